@@ -0,0 +1,162 @@
+﻿#include <benchmark/benchmark.h>
+
+#include "glapp.hpp"
+
+namespace {
+
+// Destroys all windows of the application
+void close_all_windows(glapp::app& app)
+{
+    app.exit();
+    app.run();
+}
+
+// Draws the frames of the windows while the benchmark keeps running
+// Each iteration is a frame of the first window
+void run_frames(benchmark::State& state, glapp::run_mode mode, int32_t window_count)
+{
+    auto app = glapp::get();
+    std::vector<std::shared_ptr<glapp::window>> windows;
+    for (int32_t i = 0; i < window_count; ++i) {
+        windows.push_back(app->add_window(64, 64, "bench"));
+    }
+    bool finished = false;
+    windows.front()->on_frame([&](glapp::window&) {
+        if (!finished && !state.KeepRunning()) {
+            finished = true;
+            app->exit();
+        }
+    });
+    app->run(mode);
+    state.SetItemsProcessed(state.iterations() * window_count);
+}
+
+} // namespace
+
+// Overhead of drawing the windows in series by 'app::draw_windows', reported per window by items_per_second
+void BM_DrawWindows(benchmark::State& state)
+{
+    run_frames(state, glapp::run_mode::single_thread, static_cast<int32_t>(state.range(0)));
+}
+BENCHMARK(BM_DrawWindows)->RangeMultiplier(2)->Range(1, 32)->UseRealTime();
+
+// Throughput of the run modes, 0: run(), 1: run(true), 2: thread per window
+void BM_RunMode(benchmark::State& state)
+{
+    run_frames(state, static_cast<glapp::run_mode>(state.range(0)), static_cast<int32_t>(state.range(1)));
+}
+BENCHMARK(BM_RunMode)->ArgsProduct({ { 0, 1, 2 }, { 1, 8 } })->UseRealTime();
+
+// Cost from the GLFW callback to the subscribed callback, without running the event loop
+template <typename Setup, typename Invoke>
+void dispatch(benchmark::State& state, Setup setup, Invoke invoke)
+{
+    auto app = glapp::get();
+    auto w = app->add_window(64, 64, "bench");
+    int64_t count = 0;
+    setup(*w, count);
+    for (auto _ : state) {
+        invoke(w->glfw_handle());
+    }
+    benchmark::DoNotOptimize(count);
+    state.SetItemsProcessed(state.iterations());
+    close_all_windows(*app);
+}
+
+void BM_DispatchKey(benchmark::State& state)
+{
+    GLFWkeyfun callback = nullptr;
+    dispatch(
+        state,
+        [&](glapp::window& w, int64_t& count) {
+            w.on_key([&](glapp::window&, glapp::key, const glapp::key_state&, const glapp::modifier&) { ++count; });
+            callback = glfwSetKeyCallback(w.glfw_handle(), nullptr);
+            glfwSetKeyCallback(w.glfw_handle(), callback);
+        },
+        [&](GLFWwindow* handle) { callback(handle, GLFW_KEY_A, 0, GLFW_PRESS, 0); });
+}
+BENCHMARK(BM_DispatchKey);
+
+void BM_DispatchMouseButton(benchmark::State& state)
+{
+    GLFWmousebuttonfun callback = nullptr;
+    dispatch(
+        state,
+        [&](glapp::window& w, int64_t& count) {
+            w.on_mouse_button([&](glapp::window&, glapp::mouse_button, const glapp::button_state&, const glapp::modifier&) { ++count; });
+            callback = glfwSetMouseButtonCallback(w.glfw_handle(), nullptr);
+            glfwSetMouseButtonCallback(w.glfw_handle(), callback);
+        },
+        [&](GLFWwindow* handle) { callback(handle, GLFW_MOUSE_BUTTON_LEFT, GLFW_PRESS, 0); });
+}
+BENCHMARK(BM_DispatchMouseButton);
+
+void BM_DispatchMousePos(benchmark::State& state)
+{
+    GLFWcursorposfun callback = nullptr;
+    dispatch(
+        state,
+        [&](glapp::window& w, int64_t& count) {
+            w.on_mouse_pos([&](glapp::window&, double, double) { ++count; });
+            callback = glfwSetCursorPosCallback(w.glfw_handle(), nullptr);
+            glfwSetCursorPosCallback(w.glfw_handle(), callback);
+        },
+        [&](GLFWwindow* handle) { callback(handle, 10.0, 20.0); });
+}
+BENCHMARK(BM_DispatchMousePos);
+
+void BM_DispatchMouseWheel(benchmark::State& state)
+{
+    GLFWscrollfun callback = nullptr;
+    dispatch(
+        state,
+        [&](glapp::window& w, int64_t& count) {
+            w.on_mouse_wheel([&](glapp::window&, double, double) { ++count; });
+            callback = glfwSetScrollCallback(w.glfw_handle(), nullptr);
+            glfwSetScrollCallback(w.glfw_handle(), callback);
+        },
+        [&](GLFWwindow* handle) { callback(handle, 0.0, 1.0); });
+}
+BENCHMARK(BM_DispatchMouseWheel);
+
+void BM_DispatchWindowSize(benchmark::State& state)
+{
+    GLFWwindowsizefun callback = nullptr;
+    dispatch(
+        state,
+        [&](glapp::window& w, int64_t& count) {
+            w.on_window_size([&](glapp::window&, int32_t, int32_t) { ++count; });
+            callback = glfwSetWindowSizeCallback(w.glfw_handle(), nullptr);
+            glfwSetWindowSizeCallback(w.glfw_handle(), callback);
+        },
+        [&](GLFWwindow* handle) { callback(handle, 64, 64); });
+}
+BENCHMARK(BM_DispatchWindowSize);
+
+void BM_PlacedMonitor(benchmark::State& state)
+{
+    auto app = glapp::get();
+    auto w = app->add_window(64, 64, "bench");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(w->placed_monitor());
+    }
+    close_all_windows(*app);
+}
+BENCHMARK(BM_PlacedMonitor);
+
+// Conversion of a 720p frame by the recorder on a single thread
+void BM_RgbaToI420(benchmark::State& state)
+{
+    const int32_t width = 1280;
+    const int32_t height = 720;
+    std::vector<uint8_t> rgba(width * height * 4, 128);
+    std::vector<uint8_t> planes(width * height * 3 / 2);
+    for (auto _ : state) {
+        glapp::internal::rgba_to_i420(rgba.data(), width, height, 0, height / 2, planes.data(), planes.data() + width * height, planes.data() + width * height * 5 / 4);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(rgba.size()));
+}
+BENCHMARK(BM_RgbaToI420);
+
+BENCHMARK_MAIN();
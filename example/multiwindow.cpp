@@ -10,7 +10,7 @@
 #include "glapp.hpp"
 
 void frame(glapp::window& window);
-void key(glapp::window& window, const std::string& key_name, const glapp::key_state& state, const glapp::modifier& modifier);
+void key(glapp::window& window, glapp::key key, const glapp::key_state& state, const glapp::modifier& modifier);
 
 int main()
 {
@@ -37,10 +37,7 @@ int main()
     return app->run();
 }
 
-#include <chrono>
 #include <iomanip>
-#include <iostream>
-#include <map>
 #include <sstream>
 
 void frame(glapp::window& window)
@@ -57,12 +54,7 @@ void frame(glapp::window& window)
         0.0f, 1.0f, 0.0f,
         0.0f, 0.0f, 1.0f
     };
-    static std::map<std::string, std::chrono::time_point<std::chrono::high_resolution_clock>> last_time;
-    static std::map<std::string, int64_t> last_frame;
-    const auto& tag = window.tag();
     if (window.frame_count() == 0) {
-        last_frame[tag] = 0;
-        last_time[tag] = std::chrono::high_resolution_clock::now();
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glEnableClientState(GL_VERTEX_ARRAY);
         glEnableClientState(GL_COLOR_ARRAY);
@@ -81,34 +73,32 @@ void frame(glapp::window& window)
     glRotatef(-0.1f, 0.0f, 0.0f, 1.0f);
     glDrawArrays(GL_TRIANGLES, 0, 3);
 
-    double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - last_time[tag]).count();
-    if (0.5 <= elapsed || window.frame_count() == 0) {
+    if (window.frame_count() % 30 == 0) {
         std::stringstream title;
-        double fps = (window.frame_count() - last_frame[tag]) / elapsed;
-        last_time[tag] = std::chrono::high_resolution_clock::now();
-        last_frame[tag] = window.frame_count();
+        const auto stats = window.frame_stats();
 
         // Show status on tile bar
         title << window.title_original().c_str() << " - ";
         title << window.framebuffer_size().width() << " x " << window.framebuffer_size().height() << " | ";
-        title << std::fixed << std::setprecision(2) << fps << " fps | ";
-        title << std::fixed << std::setprecision(2) << (1000.0 / fps) << " ms";
+        title << std::fixed << std::setprecision(2) << stats.fps() << " fps | ";
+        title << std::fixed << std::setprecision(2) << (stats.interval().p99() * 1000.0) << " ms (p99) | ";
+        title << stats.dropped_frames() << " dropped";
         window.set_title(title.str().c_str());
     }
 }
 
-void key(glapp::window& window, const std::string& key_name, const glapp::key_state& state, const glapp::modifier& modifier)
+void key(glapp::window& window, glapp::key key, const glapp::key_state& state, const glapp::modifier& modifier)
 {
     (void)modifier;
     if (state.pressed()) {
-        if (key_name == "f11") {
+        if (key == glapp::key::f11) {
             // Toggle fullscreen
             if (window.state() == glapp::window_state::fullscreen) {
                 window.restore();
             } else {
                 window.fullscreen();
             }
-        } else if (key_name == "escape") {
+        } else if (key == glapp::key::escape) {
             window.close();
         } else {
         }
@@ -10,7 +10,7 @@
 #include "glapp.hpp"
 
 void frame(glapp::window& window);
-void key(glapp::window& window, const std::string& key_name, const glapp::key_state& state, const glapp::modifier& modifier);
+void key(glapp::window& window, glapp::key key, const glapp::key_state& state, const glapp::modifier& modifier);
 
 int main()
 {
@@ -87,18 +87,18 @@ void frame(glapp::window& window)
     }
 }
 
-void key(glapp::window& window, const std::string& key_name, const glapp::key_state& state, const glapp::modifier& modifier)
+void key(glapp::window& window, glapp::key key, const glapp::key_state& state, const glapp::modifier& modifier)
 {
     (void)modifier;
     if (state.pressed()) {
-        if (key_name == "f11") {
+        if (key == glapp::key::f11) {
             // Toggle fullscreen
             if (window.state() == glapp::window_state::fullscreen) {
                 window.restore();
             } else {
                 window.fullscreen();
             }
-        } else if (key_name == "escape") {
+        } else if (key == glapp::key::escape) {
             window.close();
         } else {
         }
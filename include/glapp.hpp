@@ -4,20 +4,66 @@
 
 #include <algorithm>
 #include <atomic>
+#include <bitset>
 #include <cassert>
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
 #include <functional>
 #include <future>
+#include <iomanip>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
 #include <thread>
-#include <unordered_map>
+#include <type_traits>
 #include <vector>
 
+// The frames are exported through the shared memory only where the 64-bit atomics in it work across processes without locks
+#if (defined(__unix__) || defined(__APPLE__)) && (ATOMIC_LLONG_LOCK_FREE == 2)
+#define GLAPP_SHARED_MEMORY
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if !defined(GLAPP_DISABLE_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && 2 <= _M_IX86_FP))
+#define GLAPP_SSE2
+#include <emmintrin.h>
+#endif
+
+// Calling convention of OpenGL functions obtained by 'glfwGetProcAddress'
+#if defined(_WIN32)
+#define GLAPP_GL_APIENTRY __stdcall
+#else
+#define GLAPP_GL_APIENTRY
+#endif
+
+#define GLAPP_CONCAT_IMPL(a, b) a##b
+#define GLAPP_CONCAT(a, b) GLAPP_CONCAT_IMPL(a, b)
+
+// Profiling zones and counters, including the ones of glapp itself, are compiled out by defining GLAPP_DISABLE_PROFILING
+#if !defined(GLAPP_DISABLE_PROFILING)
+// Records the duration of the enclosing scope as a trace event while tracing, see 'app::start_trace'
+// name - must be a string with static storage duration, such as a string literal
+#define GLAPP_ZONE(name) ::glapp::trace_scope GLAPP_CONCAT(glapp_zone_, __LINE__)(name)
+// Records the value of the counter as a trace event while tracing
+#define GLAPP_COUNTER(name, value) ::glapp::trace_counter(name, static_cast<double>(value))
+// Zone related to the window, only for use in 'window' and 'app'
+#define GLAPP_INTERNAL_ZONE(name, window_id) ::glapp::trace_scope GLAPP_CONCAT(glapp_zone_, __LINE__)(name, window_id)
+#else
+#define GLAPP_ZONE(name) static_cast<void>(0)
+#define GLAPP_COUNTER(name, value) static_cast<void>(0)
+#define GLAPP_INTERNAL_ZONE(name, window_id) static_cast<void>(0)
+#endif
+
 namespace glapp {
 
 namespace internal {
@@ -56,132 +102,435 @@ namespace internal {
         constexpr T* get() const noexcept { return handle_; }
     };
 
+    // Unbounded lock-free queue for single producer and single consumer
+    // Elements are stored in the blocks of fixed size, so that memory is allocated only when a block is filled up
+    template <typename T, size_t BlockSize = 256>
+    class spsc_queue : noncopyable {
+    private:
+        struct block {
+            T items[BlockSize] {};
+            std::atomic<size_t> count { 0 };
+            std::atomic<block*> next { nullptr };
+        };
+
+        // Following members are accessed only by the consumer
+        block* head_ = nullptr;
+        size_t head_index_ = 0;
+        // Following member is accessed only by the producer
+        block* tail_ = nullptr;
+        // Block consumed and handed back to the producer for reuse
+        std::atomic<block*> spare_ { nullptr };
+
+    public:
+        spsc_queue()
+            : head_(new block())
+            , tail_(head_)
+        {
+        }
+
+        ~spsc_queue()
+        {
+            while (head_ != nullptr) {
+                auto next = head_->next.load(std::memory_order_relaxed);
+                delete head_;
+                head_ = next;
+            }
+            delete spare_.load(std::memory_order_relaxed);
+        }
+
+        // This function must be called only from the producer thread
+        void push(T&& item)
+        {
+            auto count = tail_->count.load(std::memory_order_relaxed);
+            if (count == BlockSize) {
+                auto next = spare_.exchange(nullptr, std::memory_order_acquire);
+                if (next == nullptr) {
+                    next = new block();
+                }
+                tail_->next.store(next, std::memory_order_release);
+                tail_ = next;
+                count = 0;
+            }
+            tail_->items[count] = std::move(item);
+            tail_->count.store(count + 1, std::memory_order_release);
+        }
+
+        // This function must be called only from the consumer thread
+        // Returns false if the queue is empty
+        bool pop(T& item)
+        {
+            if (head_index_ == BlockSize) {
+                auto next = head_->next.load(std::memory_order_acquire);
+                if (next == nullptr) {
+                    return false;
+                }
+                recycle(head_);
+                head_ = next;
+                head_index_ = 0;
+            }
+            if (head_index_ < head_->count.load(std::memory_order_acquire)) {
+                item = std::move(head_->items[head_index_]);
+                ++head_index_;
+                return true;
+            }
+            return false;
+        }
+
+    private:
+        void recycle(block* consumed)
+        {
+            consumed->count.store(0, std::memory_order_relaxed);
+            consumed->next.store(nullptr, std::memory_order_relaxed);
+            delete spare_.exchange(consumed, std::memory_order_release);
+        }
+    };
+
+    // Unbounded lock-free queue for multiple producers and single consumer
+    // Pushing is wait-free, each element is allocated in its own node linked after the last pushed one
+    template <typename T>
+    class mpsc_queue : noncopyable {
+    private:
+        struct node {
+            T item {};
+            std::atomic<node*> next { nullptr };
+        };
+
+        // Last pushed node, shared by the producers
+        std::atomic<node*> head_;
+        // Following member is accessed only by the consumer
+        // Node popped last, whose next node holds the next item
+        node* tail_ = nullptr;
+
+    public:
+        mpsc_queue()
+            : head_(new node())
+            , tail_(head_.load(std::memory_order_relaxed))
+        {
+        }
+
+        ~mpsc_queue()
+        {
+            while (tail_ != nullptr) {
+                auto next = tail_->next.load(std::memory_order_relaxed);
+                delete tail_;
+                tail_ = next;
+            }
+        }
+
+        // This function can be called from any thread
+        void push(T&& item)
+        {
+            auto pushed = new node();
+            pushed->item = std::move(item);
+            auto prev = head_.exchange(pushed, std::memory_order_acq_rel);
+            prev->next.store(pushed, std::memory_order_release);
+        }
+
+        // This function must be called only from the consumer thread
+        // Returns false if the queue is empty, or if the item being pushed is not linked yet
+        bool pop(T& item)
+        {
+            auto next = tail_->next.load(std::memory_order_acquire);
+            if (next == nullptr) {
+                return false;
+            }
+            item = std::move(next->item);
+            // Release the resources held by the item now, since the node is kept until the next pop
+            next->item = T {};
+            delete tail_;
+            tail_ = next;
+            return true;
+        }
+    };
+
+    // Pair of 32-bit values which are written and read together atomically
+    template <typename T>
+    class atomic_pair {
+        static_assert(sizeof(T) == sizeof(uint32_t), "T must be 32-bit type");
+
+    private:
+        std::atomic<uint64_t> bits_ { 0 };
+
+    public:
+        void store(T first, T second)
+        {
+            uint32_t first_bits = 0;
+            uint32_t second_bits = 0;
+            std::memcpy(&first_bits, &first, sizeof(first_bits));
+            std::memcpy(&second_bits, &second, sizeof(second_bits));
+            bits_.store((static_cast<uint64_t>(first_bits) << 32) | second_bits, std::memory_order_relaxed);
+        }
+
+        void load(T& first, T& second) const
+        {
+            const auto bits = bits_.load(std::memory_order_relaxed);
+            const auto first_bits = static_cast<uint32_t>(bits >> 32);
+            const auto second_bits = static_cast<uint32_t>(bits);
+            std::memcpy(&first, &first_bits, sizeof(first));
+            std::memcpy(&second, &second_bits, sizeof(second));
+        }
+    };
+
+    template <typename Signature>
+    class delegate;
+
+    // Move-only callable wrapper like 'std::function'
+    // The callable is stored in the inline buffer without memory allocation if it fits, otherwise on the heap
+    template <typename... Args>
+    class delegate<void(Args...)> : noncopyable {
+    private:
+        static constexpr size_t buffer_size = 4 * sizeof(void*);
+        using storage_type = typename std::aligned_storage<buffer_size, alignof(std::max_align_t)>::type;
+        using invoke_function = void (*)(void*, Args...);
+        // Moves the callable from 'src' into 'dst' and destroys 'src', or only destroys 'src' if 'dst' is null
+        using manage_function = void (*)(void* dst, void* src);
+
+        template <typename F>
+        struct fits_inline {
+            static constexpr bool value = sizeof(F) <= buffer_size && alignof(F) <= alignof(storage_type) && std::is_nothrow_move_constructible<F>::value;
+        };
+
+        template <typename F>
+        struct inline_functions {
+            static void invoke(void* storage, Args... args) { (*static_cast<F*>(storage))(args...); }
+            static void manage(void* dst, void* src)
+            {
+                if (dst != nullptr) {
+                    new (dst) F(std::move(*static_cast<F*>(src)));
+                }
+                static_cast<F*>(src)->~F();
+            }
+        };
+
+        template <typename F>
+        struct heap_functions {
+            static void invoke(void* storage, Args... args) { (**static_cast<F**>(storage))(args...); }
+            static void manage(void* dst, void* src)
+            {
+                if (dst != nullptr) {
+                    *static_cast<F**>(dst) = *static_cast<F**>(src);
+                } else {
+                    delete *static_cast<F**>(src);
+                }
+            }
+        };
+
+        storage_type storage_;
+        invoke_function invoke_ = nullptr;
+        manage_function manage_ = nullptr;
+
+    public:
+        delegate() = default;
+
+        template <typename T, typename F = typename std::decay<T>::type, typename = typename std::enable_if<!std::is_same<F, delegate>::value>::type>
+        delegate(T&& callable)
+        {
+            assign<F>(std::forward<T>(callable), std::integral_constant<bool, fits_inline<F>::value>());
+        }
+
+        delegate(delegate&& other) noexcept
+        {
+            take(other);
+        }
+
+        delegate& operator=(delegate&& other) noexcept
+        {
+            if (this != &other) {
+                reset();
+                take(other);
+            }
+            return *this;
+        }
+
+        ~delegate()
+        {
+            reset();
+        }
+
+        void operator()(Args... args)
+        {
+            invoke_(&storage_, args...);
+        }
+
+        explicit operator bool() const { return invoke_ != nullptr; }
+
+        void reset()
+        {
+            if (manage_ != nullptr) {
+                manage_(nullptr, &storage_);
+            }
+            invoke_ = nullptr;
+            manage_ = nullptr;
+        }
+
+    private:
+        template <typename F, typename T>
+        void assign(T&& callable, std::true_type)
+        {
+            new (&storage_) F(std::forward<T>(callable));
+            invoke_ = &inline_functions<F>::invoke;
+            manage_ = &inline_functions<F>::manage;
+        }
+
+        template <typename F, typename T>
+        void assign(T&& callable, std::false_type)
+        {
+            *reinterpret_cast<F**>(&storage_) = new F(std::forward<T>(callable));
+            invoke_ = &heap_functions<F>::invoke;
+            manage_ = &heap_functions<F>::manage;
+        }
+
+        void take(delegate& other) noexcept
+        {
+            if (other.manage_ != nullptr) {
+                other.manage_(&storage_, &other.storage_);
+            }
+            invoke_ = other.invoke_;
+            manage_ = other.manage_;
+            other.invoke_ = nullptr;
+            other.manage_ = nullptr;
+        }
+    };
+
+    // Table of key names indexed by the GLFW key code
+    struct key_name_table {
+        const char* names[GLFW_KEY_LAST + 1] {};
+
+        constexpr key_name_table()
+        {
+            names[GLFW_KEY_SPACE] = "space";
+            // names[GLFW_KEY_APOSTROPHE] = "'";
+            // names[GLFW_KEY_COMMA] = ",";
+            // names[GLFW_KEY_MINUS] = "-";
+            // names[GLFW_KEY_PERIOD] = ".";
+            // names[GLFW_KEY_SLASH] = "/";
+            names[GLFW_KEY_0] = "0";
+            names[GLFW_KEY_1] = "1";
+            names[GLFW_KEY_2] = "2";
+            names[GLFW_KEY_3] = "3";
+            names[GLFW_KEY_4] = "4";
+            names[GLFW_KEY_5] = "5";
+            names[GLFW_KEY_6] = "6";
+            names[GLFW_KEY_7] = "7";
+            names[GLFW_KEY_8] = "8";
+            names[GLFW_KEY_9] = "9";
+            // names[GLFW_KEY_SEMICOLON] = ";";
+            // names[GLFW_KEY_EQUAL] = "=";
+            names[GLFW_KEY_A] = "a";
+            names[GLFW_KEY_B] = "b";
+            names[GLFW_KEY_C] = "c";
+            names[GLFW_KEY_D] = "d";
+            names[GLFW_KEY_E] = "e";
+            names[GLFW_KEY_F] = "f";
+            names[GLFW_KEY_G] = "g";
+            names[GLFW_KEY_H] = "h";
+            names[GLFW_KEY_I] = "i";
+            names[GLFW_KEY_J] = "j";
+            names[GLFW_KEY_K] = "k";
+            names[GLFW_KEY_L] = "l";
+            names[GLFW_KEY_M] = "m";
+            names[GLFW_KEY_N] = "n";
+            names[GLFW_KEY_O] = "o";
+            names[GLFW_KEY_P] = "p";
+            names[GLFW_KEY_Q] = "q";
+            names[GLFW_KEY_R] = "r";
+            names[GLFW_KEY_S] = "s";
+            names[GLFW_KEY_T] = "t";
+            names[GLFW_KEY_U] = "u";
+            names[GLFW_KEY_V] = "v";
+            names[GLFW_KEY_W] = "w";
+            names[GLFW_KEY_X] = "x";
+            names[GLFW_KEY_Y] = "y";
+            names[GLFW_KEY_Z] = "z";
+            // names[GLFW_KEY_LEFT_BRACKET] = "(";
+            // names[GLFW_KEY_BACKSLASH] = "\\";
+            // names[GLFW_KEY_RIGHT_BRACKET] = ")";
+            // names[GLFW_KEY_GRAVE_ACCENT] = "`";
+            // names[GLFW_KEY_WORLD_1] = "";
+            // names[GLFW_KEY_WORLD_2] = "";
+            names[GLFW_KEY_ESCAPE] = "escape";
+            names[GLFW_KEY_ENTER] = "enter";
+            names[GLFW_KEY_TAB] = "tab";
+            names[GLFW_KEY_BACKSPACE] = "backspace";
+            names[GLFW_KEY_INSERT] = "insert";
+            names[GLFW_KEY_DELETE] = "delete";
+            names[GLFW_KEY_RIGHT] = "right";
+            names[GLFW_KEY_LEFT] = "left";
+            names[GLFW_KEY_DOWN] = "down";
+            names[GLFW_KEY_UP] = "up";
+            names[GLFW_KEY_PAGE_UP] = "pageup";
+            names[GLFW_KEY_PAGE_DOWN] = "pagedown";
+            names[GLFW_KEY_HOME] = "home";
+            names[GLFW_KEY_END] = "end";
+            names[GLFW_KEY_CAPS_LOCK] = "capslock";
+            names[GLFW_KEY_SCROLL_LOCK] = "scrolllock";
+            names[GLFW_KEY_NUM_LOCK] = "numlock";
+            names[GLFW_KEY_PRINT_SCREEN] = "printscreen";
+            names[GLFW_KEY_PAUSE] = "pause";
+            names[GLFW_KEY_F1] = "f1";
+            names[GLFW_KEY_F2] = "f2";
+            names[GLFW_KEY_F3] = "f3";
+            names[GLFW_KEY_F4] = "f4";
+            names[GLFW_KEY_F5] = "f5";
+            names[GLFW_KEY_F6] = "f6";
+            names[GLFW_KEY_F7] = "f7";
+            names[GLFW_KEY_F8] = "f8";
+            names[GLFW_KEY_F9] = "f9";
+            names[GLFW_KEY_F10] = "f10";
+            names[GLFW_KEY_F11] = "f11";
+            names[GLFW_KEY_F12] = "f12";
+            names[GLFW_KEY_F13] = "f13";
+            names[GLFW_KEY_F14] = "f14";
+            names[GLFW_KEY_F15] = "f15";
+            names[GLFW_KEY_F16] = "f16";
+            names[GLFW_KEY_F17] = "f17";
+            names[GLFW_KEY_F18] = "f18";
+            names[GLFW_KEY_F19] = "f19";
+            names[GLFW_KEY_F20] = "f20";
+            names[GLFW_KEY_F21] = "f21";
+            names[GLFW_KEY_F22] = "f22";
+            names[GLFW_KEY_F23] = "f23";
+            names[GLFW_KEY_F24] = "f24";
+            names[GLFW_KEY_F25] = "f25";
+            names[GLFW_KEY_KP_0] = "num0";
+            names[GLFW_KEY_KP_1] = "num1";
+            names[GLFW_KEY_KP_2] = "num2";
+            names[GLFW_KEY_KP_3] = "num3";
+            names[GLFW_KEY_KP_4] = "num4";
+            names[GLFW_KEY_KP_5] = "num5";
+            names[GLFW_KEY_KP_6] = "num6";
+            names[GLFW_KEY_KP_7] = "num7";
+            names[GLFW_KEY_KP_8] = "num8";
+            names[GLFW_KEY_KP_9] = "num9";
+            // names[GLFW_KEY_KP_DECIMAL] = "decimal";
+            // names[GLFW_KEY_KP_DIVIDE] = "/";
+            // names[GLFW_KEY_KP_MULTIPLY] = "*";
+            // names[GLFW_KEY_KP_SUBTRACT] = "-";
+            // names[GLFW_KEY_KP_ADD] = "+";
+            names[GLFW_KEY_KP_ENTER] = "enter";
+            // names[GLFW_KEY_KP_EQUAL] = "=";
+            names[GLFW_KEY_LEFT_SHIFT] = "lshift";
+            names[GLFW_KEY_LEFT_CONTROL] = "lcontrol";
+            names[GLFW_KEY_LEFT_ALT] = "lalt";
+            names[GLFW_KEY_LEFT_SUPER] = "lsuper";
+            names[GLFW_KEY_RIGHT_SHIFT] = "rshift";
+            names[GLFW_KEY_RIGHT_CONTROL] = "rcontrol";
+            names[GLFW_KEY_RIGHT_ALT] = "ralt";
+            names[GLFW_KEY_RIGHT_SUPER] = "rsuper";
+            names[GLFW_KEY_MENU] = "menu";
+        }
+    };
+
+    template <typename T = void>
+    struct key_names {
+        static constexpr key_name_table table {};
+    };
+    template <typename T>
+    constexpr key_name_table key_names<T>::table;
+
     constexpr const char* key_to_name(int key)
     {
-        // clang-format off
-        return
-            (key == GLFW_KEY_SPACE) ? "space" :
-            // (key == GLFW_KEY_APOSTROPHE) ? "'" :
-            // (key == GLFW_KEY_COMMA) ? "," :
-            // (key == GLFW_KEY_MINUS) ? "-" :
-            // (key == GLFW_KEY_PERIOD) ? "." :
-            // (key == GLFW_KEY_SLASH) ? "/" :
-            (key == GLFW_KEY_0) ? "0" :
-            (key == GLFW_KEY_1) ? "1" :
-            (key == GLFW_KEY_2) ? "2" :
-            (key == GLFW_KEY_3) ? "3" :
-            (key == GLFW_KEY_4) ? "4" :
-            (key == GLFW_KEY_5) ? "5" :
-            (key == GLFW_KEY_6) ? "6" :
-            (key == GLFW_KEY_7) ? "7" :
-            (key == GLFW_KEY_8) ? "8" :
-            (key == GLFW_KEY_9) ? "9" :
-            // (key == GLFW_KEY_SEMICOLON) ? ";" :
-            // (key == GLFW_KEY_EQUAL) ? "=" :
-            (key == GLFW_KEY_A) ? "a" :
-            (key == GLFW_KEY_B) ? "b" :
-            (key == GLFW_KEY_C) ? "c" :
-            (key == GLFW_KEY_D) ? "d" :
-            (key == GLFW_KEY_E) ? "e" :
-            (key == GLFW_KEY_F) ? "f" :
-            (key == GLFW_KEY_G) ? "g" :
-            (key == GLFW_KEY_H) ? "h" :
-            (key == GLFW_KEY_I) ? "i" :
-            (key == GLFW_KEY_J) ? "j" :
-            (key == GLFW_KEY_K) ? "k" :
-            (key == GLFW_KEY_L) ? "l" :
-            (key == GLFW_KEY_M) ? "m" :
-            (key == GLFW_KEY_N) ? "n" :
-            (key == GLFW_KEY_O) ? "o" :
-            (key == GLFW_KEY_P) ? "p" :
-            (key == GLFW_KEY_Q) ? "q" :
-            (key == GLFW_KEY_R) ? "r" :
-            (key == GLFW_KEY_S) ? "s" :
-            (key == GLFW_KEY_T) ? "t" :
-            (key == GLFW_KEY_U) ? "u" :
-            (key == GLFW_KEY_V) ? "v" :
-            (key == GLFW_KEY_W) ? "w" :
-            (key == GLFW_KEY_X) ? "x" :
-            (key == GLFW_KEY_Y) ? "y" :
-            (key == GLFW_KEY_Z) ? "z" :
-            // (key == GLFW_KEY_LEFT_BRACKET) ? "(" :
-            // (key == GLFW_KEY_BACKSLASH) ? "\\" :
-            // (key == GLFW_KEY_RIGHT_BRACKET) ? ")" :
-            // (key == GLFW_KEY_GRAVE_ACCENT) ? "`" :
-            // (key == GLFW_KEY_WORLD_1) ? "" :
-            // (key == GLFW_KEY_WORLD_2) ? "" :
-            (key == GLFW_KEY_ESCAPE) ? "escape" :
-            (key == GLFW_KEY_ENTER) ? "enter" :
-            (key == GLFW_KEY_TAB) ? "tab" :
-            (key == GLFW_KEY_BACKSPACE) ? "backspace" :
-            (key == GLFW_KEY_INSERT) ? "insert" :
-            (key == GLFW_KEY_DELETE) ? "delete" :
-            (key == GLFW_KEY_RIGHT) ? "right" :
-            (key == GLFW_KEY_LEFT) ? "left" :
-            (key == GLFW_KEY_DOWN) ? "down" :
-            (key == GLFW_KEY_UP) ? "up" :
-            (key == GLFW_KEY_PAGE_UP) ? "pageup" :
-            (key == GLFW_KEY_PAGE_DOWN) ? "pagedown" :
-            (key == GLFW_KEY_HOME) ? "home" :
-            (key == GLFW_KEY_END) ? "end" :
-            (key == GLFW_KEY_CAPS_LOCK) ? "capslock" :
-            (key == GLFW_KEY_SCROLL_LOCK) ? "scrolllock" :
-            (key == GLFW_KEY_NUM_LOCK) ? "numlock" :
-            (key == GLFW_KEY_PRINT_SCREEN) ? "printscreen" :
-            (key == GLFW_KEY_PAUSE) ? "pause" :
-            (key == GLFW_KEY_F1) ? "f1" :
-            (key == GLFW_KEY_F2) ? "f2" :
-            (key == GLFW_KEY_F3) ? "f3" :
-            (key == GLFW_KEY_F4) ? "f4" :
-            (key == GLFW_KEY_F5) ? "f5" :
-            (key == GLFW_KEY_F6) ? "f6" :
-            (key == GLFW_KEY_F7) ? "f7" :
-            (key == GLFW_KEY_F8) ? "f8" :
-            (key == GLFW_KEY_F9) ? "f9" :
-            (key == GLFW_KEY_F10) ? "f10" :
-            (key == GLFW_KEY_F11) ? "f11" :
-            (key == GLFW_KEY_F12) ? "f12" :
-            (key == GLFW_KEY_F13) ? "f13" :
-            (key == GLFW_KEY_F14) ? "f14" :
-            (key == GLFW_KEY_F15) ? "f15" :
-            (key == GLFW_KEY_F16) ? "f16" :
-            (key == GLFW_KEY_F17) ? "f17" :
-            (key == GLFW_KEY_F18) ? "f18" :
-            (key == GLFW_KEY_F19) ? "f19" :
-            (key == GLFW_KEY_F20) ? "f20" :
-            (key == GLFW_KEY_F21) ? "f21" :
-            (key == GLFW_KEY_F22) ? "f22" :
-            (key == GLFW_KEY_F23) ? "f23" :
-            (key == GLFW_KEY_F24) ? "f24" :
-            (key == GLFW_KEY_F25) ? "f25" :
-            (key == GLFW_KEY_KP_0) ? "num0" :
-            (key == GLFW_KEY_KP_1) ? "num1" :
-            (key == GLFW_KEY_KP_2) ? "num2" :
-            (key == GLFW_KEY_KP_3) ? "num3" :
-            (key == GLFW_KEY_KP_4) ? "num4" :
-            (key == GLFW_KEY_KP_5) ? "num5" :
-            (key == GLFW_KEY_KP_6) ? "num6" :
-            (key == GLFW_KEY_KP_7) ? "num7" :
-            (key == GLFW_KEY_KP_8) ? "num8" :
-            (key == GLFW_KEY_KP_9) ? "num9" :
-            // (key == GLFW_KEY_KP_DECIMAL) ? "decimal" :
-            // (key == GLFW_KEY_KP_DIVIDE) ? "/" :
-            // (key == GLFW_KEY_KP_MULTIPLY) ? "*" :
-            // (key == GLFW_KEY_KP_SUBTRACT) ? "-" :
-            // (key == GLFW_KEY_KP_ADD) ? "+" :
-            (key == GLFW_KEY_KP_ENTER) ? "enter" :
-            // (key == GLFW_KEY_KP_EQUAL) ? "=" :
-            (key == GLFW_KEY_LEFT_SHIFT) ? "lshift" :
-            (key == GLFW_KEY_LEFT_CONTROL) ? "lcontrol" :
-            (key == GLFW_KEY_LEFT_ALT) ? "lalt" :
-            (key == GLFW_KEY_LEFT_SUPER) ? "lsuper" :
-            (key == GLFW_KEY_RIGHT_SHIFT) ? "rshift" :
-            (key == GLFW_KEY_RIGHT_CONTROL) ? "rcontrol" :
-            (key == GLFW_KEY_RIGHT_ALT) ? "ralt" :
-            (key == GLFW_KEY_RIGHT_SUPER) ? "rsuper" :
-            (key == GLFW_KEY_MENU) ? "menu" :
-            "";
-        // clang-format on
+        return (0 <= key && key <= GLFW_KEY_LAST && key_names<>::table.names[key] != nullptr) ? key_names<>::table.names[key] : "";
     }
 
     constexpr const char* mouse_button_to_name(int button)
@@ -200,113 +549,793 @@ namespace internal {
         return (str != nullptr) ? str : "";
     }
 
-    using glfw_window_handle = internal::handle_holder<GLFWwindow>;
-    using glfw_monitor_handle = internal::handle_holder<GLFWmonitor>;
-} // namespace internal
+    using clock = std::chrono::steady_clock;
 
-enum class cursor_mode : int32_t {
-    // Cursor motion is not limited
-    normal = GLFW_CURSOR_NORMAL,
+    // Sleeps until the deadline with high resolution
+    // The thread sleeps until shortly before the deadline and then spins for the rest,
+    // the spinning period is adapted to the oversleep observed on this thread
+    // The spinning period is capped to keep the CPU idle, so the deadline may be missed on the timer of coarse resolution
+    inline void precise_sleep_until(clock::time_point deadline)
+    {
+        constexpr clock::duration min_spin = std::chrono::microseconds(250);
+        constexpr clock::duration max_spin = std::chrono::milliseconds(2);
+        thread_local clock::duration spin = std::chrono::milliseconds(1);
+        const auto wakeup = deadline - spin;
+        if (clock::now() < wakeup) {
+            std::this_thread::sleep_until(wakeup);
+            const auto oversleep = clock::now() - wakeup;
+            spin = (std::max)(spin - spin / 8, oversleep + min_spin);
+            spin = (std::min)(spin, max_spin);
+        }
+        while (clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+    }
 
-    // Cursor to become hidden when it is over a window but still want it to behave normally
-    hidden = GLFW_CURSOR_HIDDEN,
+    // Blocks a drawing thread until the next frame is due or until it is woken up
+    // The notification is kept until the next wait, so that it is never lost while the thread is drawing
+    class wake_signal : noncopyable {
+    private:
+        std::mutex mtx_;
+        std::condition_variable cv_;
+        bool notified_ = false;
 
-    // Hide the cursor and lock it to the specified window
-    disabled = GLFW_CURSOR_DISABLED
-};
+    public:
+        void notify()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mtx_);
+                notified_ = true;
+            }
+            cv_.notify_one();
+        }
 
-template <typename T>
-class point {
-private:
-    bool valid_ {};
-    T x_ {};
-    T y_ {};
+        // Returns on the notification, or at the deadline as precisely as `precise_sleep_until`
+        // deadline - `time_point::max()` to wait without timeout
+        void wait_until(clock::time_point deadline)
+        {
+            // The waiting period left to `precise_sleep_until` for the precision
+            constexpr clock::duration spin = std::chrono::milliseconds(2);
+            {
+                std::unique_lock<std::mutex> lock(mtx_);
+                if (deadline == clock::time_point::max()) {
+                    cv_.wait(lock, [this] { return notified_; });
+                } else {
+                    cv_.wait_until(lock, deadline - spin, [this] { return notified_; });
+                }
+                if (notified_) {
+                    notified_ = false;
+                    return;
+                }
+            }
+            precise_sleep_until(deadline);
+        }
+    };
 
-public:
-    point() = default;
-    point(T width, T height)
-        : valid_(true)
-        , x_(width)
-        , y_(height)
-    {
-    }
-    operator bool() const { return valid_; }
-    T x() const { return x_; }
-    T y() const { return y_; }
-};
 
-template <typename T>
-class size {
-private:
-    bool valid_ {};
-    T width_ {};
-    T height_ {};
+    enum class trace_phase : uint8_t {
+        // Duration of the zone
+        complete,
+        // Value of the counter at the time
+        counter
+    };
 
-public:
-    size() = default;
-    size(T width, T height)
-        : valid_(true)
-        , width_(width)
-        , height_(height)
-    {
-    }
-    operator bool() const { return valid_; }
-    T width() const { return width_; }
-    T height() const { return height_; }
-};
+    // Event recorded for the trace, in Chrome trace event format
+    struct trace_record {
+        trace_phase phase;
+        // Must be a string with static storage duration, such as a string literal
+        const char* name;
+        clock::time_point begin;
+        // Only for the complete event
+        clock::duration duration;
+        // Window related to the event, 0 if not related to any window
+        uint32_t window_id;
+        // Only for the counter event
+        double value;
+    };
 
-template <typename T>
-class rect {
-private:
-    bool valid_ {};
-    T x_ {};
-    T y_ {};
-    T width_ {};
-    T height_ {};
+    // Bounded ring of the trace records written only by its owner thread and read by the thread writing the trace
+    // Records are dropped while the ring is full
+    class trace_buffer : noncopyable {
+    private:
+        static constexpr size_t capacity = 1 << 16;
+        std::unique_ptr<trace_record[]> records_ { new trace_record[capacity] };
+        std::atomic<size_t> write_index_ { 0 };
+        std::atomic<size_t> read_index_ { 0 };
+        std::atomic<size_t> dropped_count_ { 0 };
+        const uint32_t thread_id_;
+        std::atomic<const char*> thread_name_;
 
-public:
-    rect() = default;
-    rect(T x, T y, T width, T height)
-        : valid_(true)
-        , x_(x)
-        , y_(y)
-        , width_(width)
-        , height_(height)
-    {
-    }
-    rect(const glapp::point<T>& pos, const glapp::size<T>& size)
-        : valid_(true)
-        , x_(pos.x())
-        , y_(pos.y())
-        , width_(size.width())
-        , height_(size.height())
-    {
-    }
-    operator bool() const { return valid_; }
-    T x() const { return x_; }
-    T y() const { return y_; }
-    T width() const { return width_; }
-    T height() const { return height_; }
-    T left() const { return x_; }
-    T right() const { return x_ + width_; }
-    T top() const { return y_; }
-    T bottom() const { return y_ + height_; }
-    glapp::point<T> pos() const { return { x_, y_ }; }
-    glapp::size<T> size() const { return { width_, height_ }; }
-};
+    public:
+        trace_buffer(uint32_t thread_id, const char* thread_name)
+            : thread_id_(thread_id)
+            , thread_name_(thread_name)
+        {
+        }
 
-class key_state {
-    friend class window;
+        uint32_t thread_id() const { return thread_id_; }
+        const char* thread_name() const { return thread_name_; }
+        void set_thread_name(const char* name) { thread_name_ = name; }
+        size_t dropped_count() const { return dropped_count_; }
 
-private:
-    bool pressed_ = false;
-    bool repeated_ = false;
+        // This function must be called only from the owner thread
+        void push(const trace_record& record)
+        {
+            const auto index = write_index_.load(std::memory_order_relaxed);
+            if (index - read_index_.load(std::memory_order_acquire) == capacity) {
+                ++dropped_count_;
+                return;
+            }
+            records_[index % capacity] = record;
+            write_index_.store(index + 1, std::memory_order_release);
+        }
 
-public:
-    bool pressed() const { return pressed_; }
-    bool repeated() const { return repeated_; }
+        // Calls the function for each record and removes them
+        template <typename F>
+        void drain(F&& f)
+        {
+            auto index = read_index_.load(std::memory_order_relaxed);
+            const auto end = write_index_.load(std::memory_order_acquire);
+            for (; index != end; ++index) {
+                f(records_[index % capacity]);
+            }
+            read_index_.store(end, std::memory_order_release);
+        }
+    };
 
-private:
+    // Collects the trace records of all threads
+    class tracer : noncopyable {
+    private:
+        std::atomic<bool> enabled_ { false };
+        std::mutex mtx_;
+        std::vector<std::shared_ptr<trace_buffer>> buffers_;
+        // Records dropped on the threads whose buffer has been released
+        size_t released_dropped_count_ = 0;
+        uint32_t next_thread_id_ = 1;
+        clock::time_point epoch_ = clock::now();
+
+    public:
+        static tracer& instance()
+        {
+            static tracer tracer;
+            return tracer;
+        }
+
+        bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+        void set_enabled(bool enabled) { enabled_ = enabled; }
+
+        void record(const char* name, clock::time_point begin, clock::time_point end, uint32_t window_id = 0)
+        {
+            local_buffer().push({ trace_phase::complete, name, begin, end - begin, window_id, 0.0 });
+        }
+
+        void record_counter(const char* name, clock::time_point time, double value)
+        {
+            local_buffer().push({ trace_phase::counter, name, time, clock::duration::zero(), 0, value });
+        }
+
+        // Names the calling thread in the trace
+        // name - must be a string with static storage duration, such as a string literal
+        void set_thread_name(const char* name)
+        {
+            local_thread_name() = name;
+            if (local_buffer_holder()) {
+                local_buffer_holder()->set_thread_name(name);
+            }
+        }
+
+        // Returns the number of records dropped while the buffer of the thread was full since the program started
+        size_t dropped_count()
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            size_t count = released_dropped_count_;
+            for (auto&& buffer : buffers_) {
+                count += buffer->dropped_count();
+            }
+            return count;
+        }
+
+        // Writes the records in Chrome trace event format and removes them from the buffers
+        void write_json(std::ostream& os)
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            const auto flags = os.flags();
+            const auto precision = os.precision();
+            os << std::fixed << std::setprecision(3);
+            const char* separator = "\n";
+            os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+            for (auto&& buffer : buffers_) {
+                const auto tid = buffer->thread_id();
+                if (buffer->thread_name() != nullptr) {
+                    os << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid << ",\"args\":{\"name\":";
+                    write_string(os, buffer->thread_name());
+                    os << "}}";
+                    separator = ",\n";
+                }
+                buffer->drain([&](const trace_record& record) {
+                    os << separator << "{\"name\":";
+                    write_string(os, record.name);
+                    os << ",\"ph\":\"" << (record.phase == trace_phase::counter ? "C" : "X")
+                       << "\",\"pid\":1,\"tid\":" << tid << ",\"ts\":" << microseconds(record.begin - epoch_);
+                    if (record.phase == trace_phase::counter) {
+                        os << ",\"args\":{\"value\":" << record.value << "}";
+                    } else {
+                        os << ",\"dur\":" << microseconds(record.duration);
+                        if (record.window_id != 0) {
+                            os << ",\"args\":{\"window\":" << record.window_id << "}";
+                        }
+                    }
+                    os << "}";
+                    separator = ",\n";
+                });
+            }
+            os << "\n]}\n";
+            os.flags(flags);
+            os.precision(precision);
+            // Release the buffers of the threads already exited
+            buffers_.erase(
+                std::remove_if(
+                    buffers_.begin(),
+                    buffers_.end(),
+                    [this](const std::shared_ptr<trace_buffer>& buffer) {
+                        if (buffer.use_count() != 1) {
+                            return false;
+                        }
+                        released_dropped_count_ += buffer->dropped_count();
+                        return true;
+                    }),
+                buffers_.end());
+        }
+
+    private:
+        static std::shared_ptr<trace_buffer>& local_buffer_holder()
+        {
+            thread_local std::shared_ptr<trace_buffer> buffer;
+            return buffer;
+        }
+
+        static const char*& local_thread_name()
+        {
+            thread_local const char* name = nullptr;
+            return name;
+        }
+
+        // Returns the buffer of the calling thread, which is allocated on the first record
+        trace_buffer& local_buffer()
+        {
+            auto& buffer = local_buffer_holder();
+            if (!buffer) {
+                std::lock_guard<std::mutex> lock(mtx_);
+                buffer = std::make_shared<trace_buffer>(next_thread_id_++, local_thread_name());
+                buffers_.push_back(buffer);
+            }
+            return *buffer;
+        }
+
+        // Writes the string quoted and escaped for JSON
+        static void write_string(std::ostream& os, const char* str)
+        {
+            static const char hex_digits[] = "0123456789abcdef";
+            os << '"';
+            for (auto p = or_empty(str); *p != '\0'; ++p) {
+                const auto c = static_cast<unsigned char>(*p);
+                if (c == '"' || c == '\\') {
+                    os << '\\' << *p;
+                } else if (c < 0x20) {
+                    os << "\\u00" << hex_digits[c >> 4] << hex_digits[c & 0xF];
+                } else {
+                    os << *p;
+                }
+            }
+            os << '"';
+        }
+
+        static double microseconds(clock::duration duration)
+        {
+            return std::chrono::duration<double, std::micro>(duration).count();
+        }
+    };
+
+    // Fixed threads running the indexed chunks of a task in parallel with the calling thread
+    class worker_pool : noncopyable {
+    private:
+        std::vector<std::thread> threads_;
+        std::mutex mtx_;
+        std::condition_variable work_cv_;
+        std::condition_variable done_cv_;
+        const std::function<void(size_t)>* task_ = nullptr;
+        size_t chunk_count_ = 0;
+        size_t next_chunk_ = 0;
+        size_t running_count_ = 0;
+        bool stopping_ = false;
+
+    public:
+        // thread_name - name of the threads in the trace, which must be a string with static storage duration
+        worker_pool(size_t thread_count, const char* thread_name)
+        {
+            for (size_t i = 0; i < thread_count; ++i) {
+                threads_.emplace_back(&worker_pool::work, this, thread_name);
+            }
+        }
+
+        ~worker_pool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mtx_);
+                stopping_ = true;
+            }
+            work_cv_.notify_all();
+            for (auto&& thread : threads_) {
+                thread.join();
+            }
+        }
+
+        // Returns the number of threads including the calling thread
+        size_t concurrency() const { return threads_.size() + 1; }
+
+        // Calls the task with each index in [0, chunk_count) and returns after all of them are finished
+        // This function must not be called concurrently
+        void run(size_t chunk_count, const std::function<void(size_t)>& task)
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            task_ = &task;
+            chunk_count_ = chunk_count;
+            next_chunk_ = 0;
+            work_cv_.notify_all();
+            run_chunks(lock);
+            done_cv_.wait(lock, [this] { return running_count_ == 0; });
+            task_ = nullptr;
+        }
+
+    private:
+        void run_chunks(std::unique_lock<std::mutex>& lock)
+        {
+            while (task_ != nullptr && next_chunk_ < chunk_count_) {
+                const size_t index = next_chunk_++;
+                const auto* task = task_;
+                ++running_count_;
+                lock.unlock();
+                (*task)(index);
+                lock.lock();
+                if (--running_count_ == 0 && next_chunk_ == chunk_count_) {
+                    done_cv_.notify_all();
+                }
+            }
+        }
+
+        void work(const char* thread_name)
+        {
+            tracer::instance().set_thread_name(thread_name);
+            std::unique_lock<std::mutex> lock(mtx_);
+            while (true) {
+                work_cv_.wait(lock, [this] { return stopping_ || (task_ != nullptr && next_chunk_ < chunk_count_); });
+                if (stopping_) {
+                    break;
+                }
+                run_chunks(lock);
+            }
+        }
+    };
+
+    // Conversion from RGBA to I420 (planar YUV 4:2:0) in BT.601 limited range
+    // The chroma is taken from the average of each 2x2 block, and the last row and column are repeated for the odd size
+    // The SSE2 kernels produce exactly the same result as the scalar ones
+    namespace yuv {
+
+        inline uint8_t luma(const uint8_t* p)
+        {
+            return static_cast<uint8_t>(((66 * p[0] + 129 * p[1] + 25 * p[2] + 128) >> 8) + 16);
+        }
+
+        // sum - sum of the two pixels which are the rounded average of the two rows
+        inline void chroma(const int32_t* sum, uint8_t* u, uint8_t* v)
+        {
+            *u = static_cast<uint8_t>(((-38 * sum[0] - 74 * sum[1] + 112 * sum[2] + 256) >> 9) + 128);
+            *v = static_cast<uint8_t>(((112 * sum[0] - 94 * sum[1] - 18 * sum[2] + 256) >> 9) + 128);
+        }
+
+#if defined(GLAPP_SSE2)
+        // Returns the sum of each pair of 32-bit lanes in the lanes 0 to 3, from the 2 x 2 pairs
+        inline __m128i pair_sums(__m128i lo, __m128i hi)
+        {
+            lo = _mm_add_epi32(lo, _mm_srli_epi64(lo, 32));
+            hi = _mm_add_epi32(hi, _mm_srli_epi64(hi, 32));
+            return _mm_unpacklo_epi64(_mm_shuffle_epi32(lo, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_epi32(hi, _MM_SHUFFLE(2, 0, 2, 0)));
+        }
+
+        // Returns the luma of the 4 pixels in 32-bit lanes
+        inline __m128i luma4(__m128i pixels)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i coef = _mm_setr_epi16(66, 129, 25, 0, 66, 129, 25, 0);
+            const __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), coef);
+            const __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), coef);
+            return _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(pair_sums(lo, hi), _mm_set1_epi32(128)), 8), _mm_set1_epi32(16));
+        }
+
+        // Returns the sums of the adjacent pixels in 16-bit lanes, from the 4 pixels
+        inline __m128i adjacent_sums(__m128i pixels)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            __m128i lo = _mm_unpacklo_epi8(pixels, zero);
+            __m128i hi = _mm_unpackhi_epi8(pixels, zero);
+            lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+            hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+            return _mm_unpacklo_epi64(lo, hi);
+        }
+
+        // Returns the 4 chroma in the lowest 4 bytes, from the sums of 8 pixels
+        inline int32_t chroma4(__m128i sums0, __m128i sums1, __m128i coef)
+        {
+            const __m128i c = pair_sums(_mm_madd_epi16(sums0, coef), _mm_madd_epi16(sums1, coef));
+            const __m128i c32 = _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(c, _mm_set1_epi32(256)), 9), _mm_set1_epi32(128));
+            const __m128i c16 = _mm_packs_epi32(c32, c32);
+            return _mm_cvtsi128_si32(_mm_packus_epi16(c16, c16));
+        }
+#endif
+
+        inline void luma_row(const uint8_t* src, uint8_t* dst, int32_t width)
+        {
+            int32_t x = 0;
+#if defined(GLAPP_SSE2)
+            for (; x + 8 <= width; x += 8) {
+                const __m128i y0 = luma4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4)));
+                const __m128i y1 = luma4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4 + 16)));
+                const __m128i y = _mm_packs_epi32(y0, y1);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(y, y));
+            }
+#endif
+            for (; x < width; ++x) {
+                dst[x] = luma(src + x * 4);
+            }
+        }
+
+        inline void chroma_row(const uint8_t* src0, const uint8_t* src1, uint8_t* u, uint8_t* v, int32_t width)
+        {
+            int32_t x = 0;
+#if defined(GLAPP_SSE2)
+            const __m128i coef_u = _mm_setr_epi16(-38, -74, 112, 0, -38, -74, 112, 0);
+            const __m128i coef_v = _mm_setr_epi16(112, -94, -18, 0, 112, -94, -18, 0);
+            for (; x + 8 <= width; x += 8) {
+                const auto p0 = reinterpret_cast<const __m128i*>(src0 + x * 4);
+                const auto p1 = reinterpret_cast<const __m128i*>(src1 + x * 4);
+                const __m128i sums0 = adjacent_sums(_mm_avg_epu8(_mm_loadu_si128(p0), _mm_loadu_si128(p1)));
+                const __m128i sums1 = adjacent_sums(_mm_avg_epu8(_mm_loadu_si128(p0 + 1), _mm_loadu_si128(p1 + 1)));
+                const int32_t u4 = chroma4(sums0, sums1, coef_u);
+                const int32_t v4 = chroma4(sums0, sums1, coef_v);
+                std::memcpy(u + x / 2, &u4, 4);
+                std::memcpy(v + x / 2, &v4, 4);
+            }
+#endif
+            for (; x < width; x += 2) {
+                const int32_t x1 = (std::min)(x + 1, width - 1);
+                int32_t sum[3];
+                for (int32_t c = 0; c < 3; ++c) {
+                    sum[c] = ((src0[x * 4 + c] + src1[x * 4 + c] + 1) >> 1) + ((src0[x1 * 4 + c] + src1[x1 * 4 + c] + 1) >> 1);
+                }
+                chroma(sum, u + x / 2, v + x / 2);
+            }
+        }
+
+    } // namespace yuv
+
+    // Converts the chroma rows in [chroma_row_begin, chroma_row_end) and the corresponding luma rows
+    // rgba - rows are ordered from the bottom to the top, as read by glReadPixels
+    // y_plane, u_plane, v_plane - rows are ordered from the top to the bottom, and the chroma planes have the half size rounded up
+    inline void rgba_to_i420(const uint8_t* rgba, int32_t width, int32_t height, int32_t chroma_row_begin, int32_t chroma_row_end, uint8_t* y_plane, uint8_t* u_plane, uint8_t* v_plane)
+    {
+        const size_t stride = static_cast<size_t>(width) * 4;
+        const size_t chroma_width = static_cast<size_t>((width + 1) / 2);
+        for (int32_t cy = chroma_row_begin; cy < chroma_row_end; ++cy) {
+            const int32_t y0 = cy * 2;
+            const int32_t y1 = (std::min)(y0 + 1, height - 1);
+            const uint8_t* src0 = rgba + static_cast<size_t>(height - 1 - y0) * stride;
+            const uint8_t* src1 = rgba + static_cast<size_t>(height - 1 - y1) * stride;
+            yuv::luma_row(src0, y_plane + static_cast<size_t>(y0) * width, width);
+            if (y1 != y0) {
+                yuv::luma_row(src1, y_plane + static_cast<size_t>(y1) * width, width);
+            }
+            yuv::chroma_row(src0, src1, u_plane + cy * chroma_width, v_plane + cy * chroma_width, width);
+        }
+    }
+
+    // Layout of the shared memory written by 'frame_exporter' and read by 'frame_export_reader'
+    // [frame_export_header][slot 0: frame_export_slot, pixels][slot 1: ...]...
+    // Each slot is a seqlock, so that the producer never waits for the consumers
+    struct alignas(64) frame_export_header {
+        // "GLAPPFX" terminated by null
+        char magic[8];
+        uint32_t version;
+        uint32_t slot_count;
+        // Bytes of each slot including its header
+        uint64_t slot_size;
+        // Maximum bytes of the pixels in each slot
+        uint64_t capacity;
+        // Sequence number (from 1) of the latest frame written completely, 0 if no frame has been written
+        // The frame of the sequence number n is written in the slot n % slot_count
+        std::atomic<uint64_t> latest;
+    };
+
+    struct alignas(64) frame_export_slot {
+        // 2n - 1 while the frame of the sequence number n is written, and 2n after it is written
+        std::atomic<uint64_t> sequence;
+        int64_t frame_count;
+        int32_t width;
+        int32_t height;
+        // Followed by the pixels in RGBA, whose rows are ordered from the bottom to the top
+    };
+
+    constexpr uint32_t frame_export_version = 1;
+
+#if defined(GLAPP_SHARED_MEMORY)
+    static_assert(sizeof(uint64_t) == sizeof(long long) && sizeof(std::atomic<uint64_t>) == sizeof(uint64_t),
+        "The atomics in the shared memory must be lock-free 64-bit values");
+#endif
+
+    // Loads the OpenGL function of the current context, which is nullptr if not available
+    template <typename T>
+    void load_gl_proc(T& proc, const char* name)
+    {
+        proc = reinterpret_cast<T>(glfwGetProcAddress(name));
+    }
+
+    using glfw_window_handle = internal::handle_holder<GLFWwindow>;
+    using glfw_monitor_handle = internal::handle_holder<GLFWmonitor>;
+} // namespace internal
+
+enum class cursor_mode : int32_t {
+    // Cursor motion is not limited
+    normal = GLFW_CURSOR_NORMAL,
+
+    // Cursor to become hidden when it is over a window but still want it to behave normally
+    hidden = GLFW_CURSOR_HIDDEN,
+
+    // Hide the cursor and lock it to the specified window
+    disabled = GLFW_CURSOR_DISABLED
+};
+
+// Key code corresponding to the GLFW key code
+// The names of enumerators follow the names by 'glapp::key_name'
+enum class key : int32_t {
+    unknown = GLFW_KEY_UNKNOWN,
+    space = GLFW_KEY_SPACE,
+    apostrophe = GLFW_KEY_APOSTROPHE,
+    comma = GLFW_KEY_COMMA,
+    minus = GLFW_KEY_MINUS,
+    period = GLFW_KEY_PERIOD,
+    slash = GLFW_KEY_SLASH,
+    digit0 = GLFW_KEY_0,
+    digit1 = GLFW_KEY_1,
+    digit2 = GLFW_KEY_2,
+    digit3 = GLFW_KEY_3,
+    digit4 = GLFW_KEY_4,
+    digit5 = GLFW_KEY_5,
+    digit6 = GLFW_KEY_6,
+    digit7 = GLFW_KEY_7,
+    digit8 = GLFW_KEY_8,
+    digit9 = GLFW_KEY_9,
+    semicolon = GLFW_KEY_SEMICOLON,
+    equal = GLFW_KEY_EQUAL,
+    a = GLFW_KEY_A,
+    b = GLFW_KEY_B,
+    c = GLFW_KEY_C,
+    d = GLFW_KEY_D,
+    e = GLFW_KEY_E,
+    f = GLFW_KEY_F,
+    g = GLFW_KEY_G,
+    h = GLFW_KEY_H,
+    i = GLFW_KEY_I,
+    j = GLFW_KEY_J,
+    k = GLFW_KEY_K,
+    l = GLFW_KEY_L,
+    m = GLFW_KEY_M,
+    n = GLFW_KEY_N,
+    o = GLFW_KEY_O,
+    p = GLFW_KEY_P,
+    q = GLFW_KEY_Q,
+    r = GLFW_KEY_R,
+    s = GLFW_KEY_S,
+    t = GLFW_KEY_T,
+    u = GLFW_KEY_U,
+    v = GLFW_KEY_V,
+    w = GLFW_KEY_W,
+    x = GLFW_KEY_X,
+    y = GLFW_KEY_Y,
+    z = GLFW_KEY_Z,
+    leftbracket = GLFW_KEY_LEFT_BRACKET,
+    backslash = GLFW_KEY_BACKSLASH,
+    rightbracket = GLFW_KEY_RIGHT_BRACKET,
+    graveaccent = GLFW_KEY_GRAVE_ACCENT,
+    world1 = GLFW_KEY_WORLD_1,
+    world2 = GLFW_KEY_WORLD_2,
+    escape = GLFW_KEY_ESCAPE,
+    enter = GLFW_KEY_ENTER,
+    tab = GLFW_KEY_TAB,
+    backspace = GLFW_KEY_BACKSPACE,
+    insert = GLFW_KEY_INSERT,
+    delete_ = GLFW_KEY_DELETE,
+    right = GLFW_KEY_RIGHT,
+    left = GLFW_KEY_LEFT,
+    down = GLFW_KEY_DOWN,
+    up = GLFW_KEY_UP,
+    pageup = GLFW_KEY_PAGE_UP,
+    pagedown = GLFW_KEY_PAGE_DOWN,
+    home = GLFW_KEY_HOME,
+    end = GLFW_KEY_END,
+    capslock = GLFW_KEY_CAPS_LOCK,
+    scrolllock = GLFW_KEY_SCROLL_LOCK,
+    numlock = GLFW_KEY_NUM_LOCK,
+    printscreen = GLFW_KEY_PRINT_SCREEN,
+    pause = GLFW_KEY_PAUSE,
+    f1 = GLFW_KEY_F1,
+    f2 = GLFW_KEY_F2,
+    f3 = GLFW_KEY_F3,
+    f4 = GLFW_KEY_F4,
+    f5 = GLFW_KEY_F5,
+    f6 = GLFW_KEY_F6,
+    f7 = GLFW_KEY_F7,
+    f8 = GLFW_KEY_F8,
+    f9 = GLFW_KEY_F9,
+    f10 = GLFW_KEY_F10,
+    f11 = GLFW_KEY_F11,
+    f12 = GLFW_KEY_F12,
+    f13 = GLFW_KEY_F13,
+    f14 = GLFW_KEY_F14,
+    f15 = GLFW_KEY_F15,
+    f16 = GLFW_KEY_F16,
+    f17 = GLFW_KEY_F17,
+    f18 = GLFW_KEY_F18,
+    f19 = GLFW_KEY_F19,
+    f20 = GLFW_KEY_F20,
+    f21 = GLFW_KEY_F21,
+    f22 = GLFW_KEY_F22,
+    f23 = GLFW_KEY_F23,
+    f24 = GLFW_KEY_F24,
+    f25 = GLFW_KEY_F25,
+    num0 = GLFW_KEY_KP_0,
+    num1 = GLFW_KEY_KP_1,
+    num2 = GLFW_KEY_KP_2,
+    num3 = GLFW_KEY_KP_3,
+    num4 = GLFW_KEY_KP_4,
+    num5 = GLFW_KEY_KP_5,
+    num6 = GLFW_KEY_KP_6,
+    num7 = GLFW_KEY_KP_7,
+    num8 = GLFW_KEY_KP_8,
+    num9 = GLFW_KEY_KP_9,
+    numdecimal = GLFW_KEY_KP_DECIMAL,
+    numdivide = GLFW_KEY_KP_DIVIDE,
+    nummultiply = GLFW_KEY_KP_MULTIPLY,
+    numsubtract = GLFW_KEY_KP_SUBTRACT,
+    numadd = GLFW_KEY_KP_ADD,
+    numenter = GLFW_KEY_KP_ENTER,
+    numequal = GLFW_KEY_KP_EQUAL,
+    lshift = GLFW_KEY_LEFT_SHIFT,
+    lcontrol = GLFW_KEY_LEFT_CONTROL,
+    lalt = GLFW_KEY_LEFT_ALT,
+    lsuper = GLFW_KEY_LEFT_SUPER,
+    rshift = GLFW_KEY_RIGHT_SHIFT,
+    rcontrol = GLFW_KEY_RIGHT_CONTROL,
+    ralt = GLFW_KEY_RIGHT_ALT,
+    rsuper = GLFW_KEY_RIGHT_SUPER,
+    menu = GLFW_KEY_MENU
+};
+
+enum class mouse_button : int32_t {
+    left = GLFW_MOUSE_BUTTON_LEFT,
+    right = GLFW_MOUSE_BUTTON_RIGHT,
+    middle = GLFW_MOUSE_BUTTON_MIDDLE,
+    button4 = GLFW_MOUSE_BUTTON_4,
+    button5 = GLFW_MOUSE_BUTTON_5,
+    button6 = GLFW_MOUSE_BUTTON_6,
+    button7 = GLFW_MOUSE_BUTTON_7,
+    button8 = GLFW_MOUSE_BUTTON_8
+};
+
+// Returns the name of the key, or empty string if the key has no name
+// e.g. "a", "f11", "escape", "num0"
+constexpr const char* key_name(glapp::key key)
+{
+    return internal::key_to_name(static_cast<int>(key));
+}
+
+// Returns the name of the mouse button, "left", "right", "middle" or empty string
+constexpr const char* mouse_button_name(glapp::mouse_button button)
+{
+    return internal::mouse_button_to_name(static_cast<int>(button));
+}
+
+template <typename T>
+class point {
+private:
+    bool valid_ {};
+    T x_ {};
+    T y_ {};
+
+public:
+    point() = default;
+    point(T width, T height)
+        : valid_(true)
+        , x_(width)
+        , y_(height)
+    {
+    }
+    operator bool() const { return valid_; }
+    T x() const { return x_; }
+    T y() const { return y_; }
+};
+
+template <typename T>
+class size {
+private:
+    bool valid_ {};
+    T width_ {};
+    T height_ {};
+
+public:
+    size() = default;
+    size(T width, T height)
+        : valid_(true)
+        , width_(width)
+        , height_(height)
+    {
+    }
+    operator bool() const { return valid_; }
+    T width() const { return width_; }
+    T height() const { return height_; }
+};
+
+template <typename T>
+class rect {
+private:
+    bool valid_ {};
+    T x_ {};
+    T y_ {};
+    T width_ {};
+    T height_ {};
+
+public:
+    rect() = default;
+    rect(T x, T y, T width, T height)
+        : valid_(true)
+        , x_(x)
+        , y_(y)
+        , width_(width)
+        , height_(height)
+    {
+    }
+    rect(const glapp::point<T>& pos, const glapp::size<T>& size)
+        : valid_(true)
+        , x_(pos.x())
+        , y_(pos.y())
+        , width_(size.width())
+        , height_(size.height())
+    {
+    }
+    operator bool() const { return valid_; }
+    T x() const { return x_; }
+    T y() const { return y_; }
+    T width() const { return width_; }
+    T height() const { return height_; }
+    T left() const { return x_; }
+    T right() const { return x_ + width_; }
+    T top() const { return y_; }
+    T bottom() const { return y_ + height_; }
+    glapp::point<T> pos() const { return { x_, y_ }; }
+    glapp::size<T> size() const { return { width_, height_ }; }
+};
+
+class key_state {
+    friend class window;
+
+private:
+    bool pressed_ = false;
+    bool repeated_ = false;
+
+public:
+    bool pressed() const { return pressed_; }
+    bool repeated() const { return repeated_; }
+
+private:
     key_state(int state)
         : pressed_(state == GLFW_PRESS || state == GLFW_REPEAT)
         , repeated_(state == GLFW_REPEAT)
@@ -332,6 +1361,7 @@ private:
 
 class modifier {
     friend class window;
+    friend class input_state;
 
 private:
     bool shift_ = false;
@@ -361,17 +1391,54 @@ private:
     }
 };
 
-enum class opengl_api : int32_t {
-    opengl = GLFW_OPENGL_API,
-    opengl_es = GLFW_OPENGL_ES_API,
-    no = GLFW_NO_API
-};
+// Snapshot of the input to a window, taken at the start of each frame
+class input_state {
+    friend class window;
 
-enum class opengl_profile : int32_t {
-    any = GLFW_OPENGL_ANY_PROFILE,
-    compat = GLFW_OPENGL_COMPAT_PROFILE,
-    core = GLFW_OPENGL_CORE_PROFILE
-};
+private:
+    std::bitset<GLFW_KEY_LAST + 1> keys_;
+    std::bitset<GLFW_MOUSE_BUTTON_LAST + 1> buttons_;
+    double cursor_x_ = 0.0;
+    double cursor_y_ = 0.0;
+    double scroll_x_ = 0.0;
+    double scroll_y_ = 0.0;
+    int32_t mods_ = 0;
+    bool cursor_entered_ = false;
+
+public:
+    bool key_pressed(glapp::key key) const
+    {
+        const auto index = static_cast<size_t>(key);
+        return index < keys_.size() && keys_[index];
+    }
+
+    bool button_pressed(glapp::mouse_button button) const
+    {
+        const auto index = static_cast<size_t>(button);
+        return index < buttons_.size() && buttons_[index];
+    }
+
+    glapp::point<double> cursor_pos() const { return { cursor_x_, cursor_y_ }; }
+    bool cursor_entered() const { return cursor_entered_; }
+
+    // Returns the scroll offset accumulated since the previous frame
+    glapp::point<double> scroll() const { return { scroll_x_, scroll_y_ }; }
+
+    // Returns the modifier keys held on the last key or button event
+    glapp::modifier modifier() const { return glapp::modifier(mods_); }
+};
+
+enum class opengl_api : int32_t {
+    opengl = GLFW_OPENGL_API,
+    opengl_es = GLFW_OPENGL_ES_API,
+    no = GLFW_NO_API
+};
+
+enum class opengl_profile : int32_t {
+    any = GLFW_OPENGL_ANY_PROFILE,
+    compat = GLFW_OPENGL_COMPAT_PROFILE,
+    core = GLFW_OPENGL_CORE_PROFILE
+};
 
 class window_options {
     friend class window;
@@ -396,6 +1463,7 @@ private:
     bool topmost_on_created_ = false;
     bool auto_minimize = true;
     bool content_scale_to_monitor_ = false;
+    bool headless_ = false;
 
 public:
     glapp::window_options& set_opengl_version(int32_t major, int32_t minor)
@@ -490,6 +1558,13 @@ public:
         content_scale_to_monitor_ = enable;
         return *this;
     }
+    // Specifies whether to create the window never shown, which draws the frame into a framebuffer object without presenting it
+    // The window is not placed on the monitor even if it is specified
+    glapp::window_options& set_headless(bool enable)
+    {
+        headless_ = enable;
+        return *this;
+    }
 
 private:
     void apply() const
@@ -507,8 +1582,9 @@ private:
         glfwWindowHint(GLFW_SAMPLES, msaa_samples_);
         glfwWindowHint(GLFW_DOUBLEBUFFER, doublebuffer_);
         glfwWindowHint(GLFW_RESIZABLE, resizable_ ? GLFW_TRUE : GLFW_FALSE);
-        glfwWindowHint(GLFW_VISIBLE, visible_on_created_ ? GLFW_TRUE : GLFW_FALSE);
-        glfwWindowHint(GLFW_MAXIMIZED, maximize_on_created_ ? GLFW_TRUE : GLFW_FALSE);
+        glfwWindowHint(GLFW_VISIBLE, (visible_on_created_ && !headless_) ? GLFW_TRUE : GLFW_FALSE);
+        glfwWindowHint(GLFW_FOCUSED, headless_ ? GLFW_FALSE : GLFW_TRUE);
+        glfwWindowHint(GLFW_MAXIMIZED, (maximize_on_created_ && !headless_) ? GLFW_TRUE : GLFW_FALSE);
         glfwWindowHint(GLFW_FLOATING, topmost_on_created_ ? GLFW_TRUE : GLFW_FALSE);
         glfwWindowHint(GLFW_AUTO_ICONIFY, auto_minimize ? GLFW_TRUE : GLFW_FALSE);
         glfwWindowHint(GLFW_SCALE_TO_MONITOR, content_scale_to_monitor_ ? GLFW_TRUE : GLFW_FALSE);
@@ -557,7 +1633,17 @@ class monitor {
     friend class app;
 
 private:
+    // Properties queried on connecting the monitor and changing its video mode
+    struct properties {
+        glapp::monitor_mode mode;
+        glapp::rect<int32_t> rect;
+        glapp::rect<int32_t> workarea_rect;
+        glapp::size<float> content_scale;
+    };
+
     std::shared_ptr<internal::glfw_monitor_handle> handle_;
+    // Replaced as a whole by 'refresh', so that the properties can be read from any thread
+    std::shared_ptr<const properties> properties_;
 
 public:
     monitor() = default;
@@ -599,31 +1685,16 @@ public:
     // Returns the current screen size in screen coordinates
     glapp::rect<int32_t> rect() const
     {
-        glapp::rect<int32_t> rect {};
-        if (handle_) {
-            int xpos {};
-            int ypos {};
-            glfwGetMonitorPos(handle_->get(), &xpos, &ypos);
-            const auto mode = current_mode();
-            rect = { xpos, ypos, mode.width(), mode.height() };
-        }
-        return rect;
+        const auto properties = std::atomic_load(&properties_);
+        return properties ? properties->rect : glapp::rect<int32_t> {};
     }
 
 #if (3 <= GLFW_VERSION_MINOR)
     // Returns the current screen rect (not including the taskbar) in screen coordinates
     glapp::rect<int32_t> workarea_rect() const
     {
-        glapp::rect<int32_t> rect {};
-        if (handle_) {
-            int xpos {};
-            int ypos {};
-            int width {};
-            int height {};
-            glfwGetMonitorWorkarea(handle_->get(), &xpos, &ypos, &width, &height);
-            rect = { xpos, ypos, width, height };
-        }
-        return rect;
+        const auto properties = std::atomic_load(&properties_);
+        return properties ? properties->workarea_rect : glapp::rect<int32_t> {};
     }
 #endif
 
@@ -635,139 +1706,1127 @@ public:
         if (mode) {
             refresh_rate = mode.refresh_rate();
         }
-        return refresh_rate;
-    }
+        return refresh_rate;
+    }
+
+    // Returns the monitor size in millimetres (Aspect ratio is reflected)
+    glapp::size<int32_t> pysical_size() const
+    {
+        glapp::size<int32_t> size {};
+        if (handle_) {
+            int width {};
+            int height {};
+            glfwGetMonitorPhysicalSize(handle_->get(), &width, &height);
+            size = { width, height };
+        }
+        return size;
+    }
+
+    glapp::size<float> content_scale() const
+    {
+        const auto properties = std::atomic_load(&properties_);
+        return properties ? properties->content_scale : glapp::size<float> {};
+    }
+
+    glapp::monitor_mode current_mode() const
+    {
+        const auto properties = std::atomic_load(&properties_);
+        return properties ? properties->mode : glapp::monitor_mode {};
+    }
+
+    std::vector<glapp::monitor_mode> supported_modes() const
+    {
+        std::vector<glapp::monitor_mode> modes {};
+        if (handle_) {
+            int count {};
+            auto glfw_modes = glfwGetVideoModes(handle_->get(), &count);
+            if (glfw_modes != nullptr) {
+                modes.reserve(count);
+                for (int i = 0; i < count; ++i) {
+                    modes.push_back(glapp::monitor_mode(glfw_modes[i]));
+                }
+            }
+        }
+        return modes;
+    }
+
+    void set_user_pointer(void* pointer)
+    {
+        if (handle_) {
+            glfwSetMonitorUserPointer(handle_->get(), pointer);
+        }
+    }
+    void* user_pointer() const
+    {
+        void* pointer {};
+        if (handle_) {
+            pointer = glfwGetMonitorUserPointer(handle_->get());
+        }
+        return pointer;
+    }
+
+private:
+    monitor(GLFWmonitor* glfw_monitor)
+        : handle_(std::make_shared<internal::glfw_monitor_handle>(glfw_monitor, nullptr))
+    {
+        refresh();
+    }
+
+    void destroy()
+    {
+        if (handle_) {
+            handle_.reset();
+        }
+        std::atomic_store(&properties_, std::shared_ptr<const properties>());
+    }
+
+    // Queries the properties to GLFW and caches them
+    void refresh()
+    {
+        if (!handle_) {
+            return;
+        }
+        auto glfw_monitor = handle_->get();
+        auto refreshed = std::make_shared<properties>();
+        auto glfw_mode = glfwGetVideoMode(glfw_monitor);
+        if (glfw_mode != nullptr) {
+            refreshed->mode = glapp::monitor_mode(*glfw_mode);
+        }
+        int xpos {};
+        int ypos {};
+        glfwGetMonitorPos(glfw_monitor, &xpos, &ypos);
+        refreshed->rect = { xpos, ypos, refreshed->mode.width(), refreshed->mode.height() };
+#if (3 <= GLFW_VERSION_MINOR)
+        int width {};
+        int height {};
+        glfwGetMonitorWorkarea(glfw_monitor, &xpos, &ypos, &width, &height);
+        refreshed->workarea_rect = { xpos, ypos, width, height };
+#endif
+        float xscale {};
+        float yscale {};
+        glfwGetMonitorContentScale(glfw_monitor, &xscale, &yscale);
+        refreshed->content_scale = { xscale, yscale };
+        std::atomic_store(&properties_, std::shared_ptr<const properties>(std::move(refreshed)));
+    }
+};
+
+enum class window_state {
+    normal,
+    minimized,
+    maximized,
+    fullscreen
+};
+
+// Events which can be coalesced into one delivery per frame
+enum class coalescible_event {
+    mouse_pos,
+    mouse_wheel,
+    window_pos,
+    window_size,
+    window_contentscale,
+    framebuffer_size
+};
+
+enum class coalescing {
+    // Deliver every event as it arrives
+    none,
+
+    // Deliver only the latest event once per frame
+    latest,
+
+    // Deliver the sum of the offsets once per frame
+    // Only for `coalescible_event::mouse_wheel`, other events are treated as `latest`
+    accumulate
+};
+
+// GPU time of a zone measured between 'window::begin_gpu_zone' and 'window::end_gpu_zone'
+class gpu_zone_timing {
+    friend class window;
+
+private:
+    const char* name_ = "";
+    int32_t depth_ = 0;
+    double duration_ = 0.0;
+
+public:
+    gpu_zone_timing() = default;
+
+    const char* name() const { return name_; }
+    // Returns the nesting level, 0 for the outermost zones
+    int32_t depth() const { return depth_; }
+    // Returns the duration in seconds
+    double duration() const { return duration_; }
+};
+
+// GPU time of a frame, which becomes available a few frames after the frame is drawn
+class gpu_frame_timing {
+    friend class window;
+
+private:
+    int64_t frame_count_ = -1;
+    double frame_time_ = 0.0;
+    std::vector<glapp::gpu_zone_timing> zones_;
+
+public:
+    gpu_frame_timing() = default;
+
+    operator bool() const { return 0 <= frame_count_; }
+
+    // Returns the frame count of the window when the frame was drawn
+    int64_t frame_count() const { return frame_count_; }
+    // Returns the GPU time of the 'on_frame' callbacks in seconds
+    double frame_time() const { return frame_time_; }
+    // Returns the zones in the order of beginning
+    const std::vector<glapp::gpu_zone_timing>& zones() const { return zones_; }
+};
+
+// Pixels of the frame read back by 'window::capture_async'
+class captured_frame {
+    friend class window;
+    friend class frame_export_reader;
+
+private:
+    int64_t frame_count_ = 0;
+    int32_t width_ = 0;
+    int32_t height_ = 0;
+    const uint8_t* pixels_ = nullptr;
+
+public:
+    // Returns the frame count of the window when the frame was drawn
+    int64_t frame_count() const { return frame_count_; }
+    int32_t width() const { return width_; }
+    int32_t height() const { return height_; }
+    // Returns the pixels in RGBA with 8 bits per channel, whose rows are ordered from the bottom to the top
+    // They are valid only while the callback receiving this frame is running
+    const uint8_t* pixels() const { return pixels_; }
+    size_t size_in_bytes() const { return static_cast<size_t>(width_) * static_cast<size_t>(height_) * 4; }
+};
+
+// Statistics of durations in seconds
+class duration_stats {
+    friend class window;
+
+private:
+    double min_ = 0.0;
+    double max_ = 0.0;
+    double avg_ = 0.0;
+    double p50_ = 0.0;
+    double p95_ = 0.0;
+    double p99_ = 0.0;
+
+public:
+    duration_stats() = default;
+
+    double min() const { return min_; }
+    double max() const { return max_; }
+    double avg() const { return avg_; }
+    double p50() const { return p50_; }
+    double p95() const { return p95_; }
+    double p99() const { return p99_; }
+
+private:
+    // The values are sorted in place
+    duration_stats(float* values, size_t count)
+    {
+        if (count == 0) {
+            return;
+        }
+        std::sort(values, values + count);
+        double sum = 0.0;
+        for (size_t i = 0; i < count; ++i) {
+            sum += values[i];
+        }
+        min_ = values[0];
+        max_ = values[count - 1];
+        avg_ = sum / count;
+        p50_ = percentile(values, count, 0.50);
+        p95_ = percentile(values, count, 0.95);
+        p99_ = percentile(values, count, 0.99);
+    }
+
+    static double percentile(const float* sorted_values, size_t count, double p)
+    {
+        // Nearest-rank method
+        const auto rank = static_cast<size_t>(std::ceil(p * count));
+        return sorted_values[(0 < rank) ? rank - 1 : 0];
+    }
+};
+
+// Timing statistics of the recent frames of a window
+class frame_stats {
+    friend class window;
+
+private:
+    size_t sample_count_ = 0;
+    int64_t dropped_frames_ = 0;
+    glapp::duration_stats cpu_time_;
+    glapp::duration_stats swap_time_;
+    glapp::duration_stats interval_;
+
+public:
+    frame_stats() = default;
+
+    // Returns the number of the recent frames in the statistics
+    size_t sample_count() const { return sample_count_; }
+
+    // Returns the time spent in the 'on_frame' callbacks
+    const glapp::duration_stats& cpu_time() const { return cpu_time_; }
+
+    // Returns the time blocked in swapping buffers
+    const glapp::duration_stats& swap_time() const { return swap_time_; }
+
+    // Returns the time between the starts of consecutive frames
+    const glapp::duration_stats& interval() const { return interval_; }
+
+    double fps() const { return (0.0 < interval_.avg()) ? 1.0 / interval_.avg() : 0.0; }
+
+    // Returns the number of frames presented later than 1.5 times the expected interval since the window was created
+    // The expected interval is the period of the target frame rate, or the moving average of the intervals if it is not set
+    int64_t dropped_frames() const { return dropped_frames_; }
+};
+
+enum class render_mode {
+    // Draw the frame continuously
+    continuous,
+
+    // Draw the frame only after invalidated by `window::invalidate`, input or resizing
+    on_demand
+};
+
+// Specifies how to throttle the drawing of a window in the background
+// Headless windows are never throttled
+class throttle_policy {
+private:
+    bool pause_when_minimized_ = true;
+    bool pause_when_hidden_ = true;
+    double unfocused_fps_ = 0.0;
+
+public:
+    // Specifies whether to stop drawing while the window is minimized
+    glapp::throttle_policy& set_pause_when_minimized(bool enable)
+    {
+        pause_when_minimized_ = enable;
+        return *this;
+    }
+    bool pause_when_minimized() const { return pause_when_minimized_; }
+
+    // Specifies whether to stop drawing while the window is hidden by `window::set_visible`
+    // The window created hidden by `window_options::set_visible_on_created` keeps drawing until hidden explicitly
+    glapp::throttle_policy& set_pause_when_hidden(bool enable)
+    {
+        pause_when_hidden_ = enable;
+        return *this;
+    }
+    bool pause_when_hidden() const { return pause_when_hidden_; }
+
+    // Limits the frame rate while the window does not have the input focus
+    // The lower of this and `window::target_fps` is applied
+    // fps - frames per second, 0 for no limit
+    glapp::throttle_policy& set_unfocused_fps(double fps)
+    {
+        unfocused_fps_ = (0.0 < fps) ? fps : 0.0;
+        return *this;
+    }
+    double unfocused_fps() const { return unfocused_fps_; }
+};
+
+// Read-only view of the paths of dropped files without copying them
+// The paths are valid only while the callback receiving the view is running
+class path_span {
+private:
+    const char* const* paths_ = nullptr;
+    size_t size_ = 0;
+
+public:
+    path_span() = default;
+    path_span(const char* const* paths, size_t size)
+        : paths_(paths)
+        , size_(size)
+    {
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const char* operator[](size_t index) const { return paths_[index]; }
+    const char* const* begin() const { return paths_; }
+    const char* const* end() const { return paths_ + size_; }
+};
+
+// Records the duration of the scope as a trace event while tracing, see 'app::start_trace'
+// Prefer 'GLAPP_ZONE', which is compiled out together with the other profiling
+class trace_scope : internal::noncopyable {
+    friend class window;
+    friend class app;
+
+private:
+    const char* name_;
+    uint32_t window_id_ = 0;
+    internal::clock::time_point begin_ {};
+
+public:
+    // name - must be a string with static storage duration, such as a string literal
+    explicit trace_scope(const char* name)
+        : trace_scope(name, 0)
+    {
+    }
+
+    ~trace_scope()
+    {
+        if (begin_ != internal::clock::time_point {}) {
+            internal::tracer::instance().record(name_, begin_, internal::clock::now(), window_id_);
+        }
+    }
+
+private:
+    trace_scope(const char* name, uint32_t window_id)
+        : name_(name)
+        , window_id_(window_id)
+    {
+        if (internal::tracer::instance().enabled()) {
+            begin_ = internal::clock::now();
+        }
+    }
+};
+
+// Records the value of the counter as a trace event while tracing, see 'app::start_trace'
+// Prefer 'GLAPP_COUNTER', which is compiled out together with the other profiling
+// name - must be a string with static storage duration, such as a string literal
+inline void trace_counter(const char* name, double value)
+{
+    auto& tracer = internal::tracer::instance();
+    if (tracer.enabled()) {
+        tracer.record_counter(name, internal::clock::now(), value);
+    }
+}
+
+// Token returned by the 'window::on_*' functions to remove the callback by 'window::unsubscribe'
+class subscription {
+    friend class window;
+
+private:
+    uint64_t id_ = 0;
+
+public:
+    subscription() = default;
+
+    operator bool() const { return id_ != 0; }
+
+private:
+    explicit subscription(uint64_t id)
+        : id_(id)
+    {
+    }
+};
+
+class window : internal::noncopyable {
+    friend class app;
+
+private:
+    std::shared_ptr<internal::glfw_window_handle> handle_;
+    std::string title_;
+    std::string title_original_;
+    std::string tag_;
+    // Identifies the window in the trace
+    uint32_t trace_id_ = 0;
+    // Draws the frame into `offscreen_target_` and never presents it
+    bool headless_ = false;
+    bool capture_supported_ = false;
+    std::atomic<int64_t> dropped_capture_count_ { 0 };
+    // Queried on creating, since `glfwGetWindowAttrib` must be called on the main thread
+    int32_t context_version_major_ = 0;
+    int32_t context_version_minor_ = 0;
+    int32_t swap_interval_ = 0;
+    int32_t last_swap_interval_ = INT32_MAX;
+    void* user_pointer_ {};
+    int64_t frame_count_ = 0;
+    // Written by the GLFW callbacks and read by `placed_monitor` on any thread
+    internal::atomic_pair<int32_t> normal_window_pos_;
+    internal::atomic_pair<int32_t> normal_window_size_;
+    glapp::rect<int32_t> fullscreen_backup_window_rect_;
+    glapp::size<int32_t> size_limit_min_;
+    glapp::size<int32_t> size_limit_max_;
+    glapp::size<int32_t> aspect_ratio_;
+    // Following members are updated by the GLFW callbacks and the setters,
+    // so that the getters are available without querying the display server
+    internal::atomic_pair<int32_t> pos_cache_;
+    internal::atomic_pair<int32_t> size_cache_;
+    internal::atomic_pair<int32_t> framebuffer_size_cache_;
+    internal::atomic_pair<float> contentscale_cache_;
+    std::atomic<glapp::window_state> state_cache_ { glapp::window_state::normal };
+    // True after hidden by `set_visible`, not by `window_options::set_visible_on_created`
+    std::atomic<bool> hidden_ { false };
+    std::atomic<bool> focused_cache_ { false };
+    std::thread render_thread_;
+    std::atomic<bool> rendering_ {};
+    // Wakes up the thread drawing this window if it is drawn in another thread than the thread processing events
+    // Accessed by `std::atomic_load` and `std::atomic_store` since it is set while other threads may use it
+    std::shared_ptr<internal::wake_signal> drawing_signal_;
+
+    enum class event_type : uint8_t {
+        key,
+        mouse_button,
+        cursor_pos,
+        cursor_enter,
+        scroll,
+        window_pos,
+        window_size,
+        window_close,
+        window_refresh,
+        window_focus,
+        window_state,
+        window_contentscale,
+        framebuffer_size,
+        drop
+    };
+
+    // Event received from GLFW and delivered to the callbacks
+    struct queued_event {
+        event_type type {};
+        int32_t args[3] {};
+        double values[2] {};
+        // Dropped paths, the count of them is args[0]
+        // They point to the GLFW's array while delivered directly, or to 'path_storage' while queued
+        const char* const* paths = nullptr;
+        std::unique_ptr<char[]> path_storage;
+
+        queued_event() = default;
+        queued_event(event_type type, int32_t arg0 = 0, int32_t arg1 = 0, int32_t arg2 = 0)
+            : type(type)
+            , args { arg0, arg1, arg2 }
+        {
+        }
+        queued_event(event_type type, double value0, double value1)
+            : type(type)
+            , values { value0, value1 }
+        {
+        }
+    };
+
+    // Events are queued while the window is drawn in another thread than the thread processing GLFW events,
+    // and delivered on the drawing thread at the start of each frame
+    std::unique_ptr<internal::spsc_queue<queued_event>> event_queue_;
+
+    static constexpr size_t coalescible_event_count = 6;
+    std::atomic<glapp::coalescing> coalescing_[coalescible_event_count] {};
+    // Following members are accessed only by the thread delivering events
+    queued_event coalesced_events_[coalescible_event_count];
+    bool coalesced_event_pending_[coalescible_event_count] {};
+    glapp::input_state live_input_;
+    // Following member is accessed only by the drawing thread
+    glapp::input_state input_;
+    std::atomic<double> target_fps_ { 0.0 };
+    std::atomic<glapp::render_mode> render_mode_ { glapp::render_mode::continuous };
+    std::atomic<bool> invalidated_ { true };
+    std::atomic<double> update_rate_ { 60.0 };
+    std::atomic<int32_t> max_updates_per_frame_ { 8 };
+    double update_accumulator_ = 0.0;
+    internal::clock::time_point last_update_time_ {};
+    double scheduled_fps_ = 0.0;
+    internal::clock::time_point next_frame_time_ {};
+    std::atomic<bool> pause_when_minimized_ { true };
+    std::atomic<bool> pause_when_hidden_ { true };
+    std::atomic<double> unfocused_fps_ { 0.0 };
+    // Set when the drawing is found paused by the throttle policy, so that the pause is not regarded as dropping
+    mutable std::atomic<bool> paused_ { false };
+    struct frame_sample {
+        float cpu_time;
+        float swap_time;
+        // Negative if there is no previous frame
+        float interval;
+    };
+    static constexpr size_t frame_sample_capacity = 256;
+    // Locked while recording or reading the frame samples
+    mutable std::mutex frame_stats_mtx_;
+    frame_sample frame_samples_[frame_sample_capacity] {};
+    size_t frame_sample_count_ = 0;
+    int64_t dropped_frame_count_ = 0;
+    double average_interval_ = 0.0;
+    internal::clock::time_point last_frame_time_ {};
+    std::atomic<bool> gpu_timing_enabled_ { false };
+    // Bit set of the event types whose GLFW callback has been installed
+    uint32_t installed_glfw_callbacks_ = 0;
+
+    // Framebuffer object which the headless window draws the frame into, instead of the default framebuffer
+    class offscreen_target : internal::noncopyable {
+    private:
+        static constexpr uint32_t gl_framebuffer = 0x8D40;
+        static constexpr uint32_t gl_renderbuffer = 0x8D41;
+        static constexpr uint32_t gl_rgba8 = 0x8058;
+        static constexpr uint32_t gl_depth24_stencil8 = 0x88F0;
+        static constexpr uint32_t gl_color_attachment0 = 0x8CE0;
+        static constexpr uint32_t gl_depth_stencil_attachment = 0x821A;
+        static constexpr uint32_t gl_framebuffer_complete = 0x8CD5;
+
+        void(GLAPP_GL_APIENTRY* gen_framebuffers_)(int32_t, uint32_t*) = nullptr;
+        void(GLAPP_GL_APIENTRY* delete_framebuffers_)(int32_t, const uint32_t*) = nullptr;
+        void(GLAPP_GL_APIENTRY* bind_framebuffer_)(uint32_t, uint32_t) = nullptr;
+        uint32_t(GLAPP_GL_APIENTRY* check_framebuffer_status_)(uint32_t) = nullptr;
+        void(GLAPP_GL_APIENTRY* framebuffer_renderbuffer_)(uint32_t, uint32_t, uint32_t, uint32_t) = nullptr;
+        void(GLAPP_GL_APIENTRY* gen_renderbuffers_)(int32_t, uint32_t*) = nullptr;
+        void(GLAPP_GL_APIENTRY* delete_renderbuffers_)(int32_t, const uint32_t*) = nullptr;
+        void(GLAPP_GL_APIENTRY* bind_renderbuffer_)(uint32_t, uint32_t) = nullptr;
+        void(GLAPP_GL_APIENTRY* renderbuffer_storage_)(uint32_t, uint32_t, int32_t, int32_t) = nullptr;
+        // Loaded even if the framebuffer object is not supported, since libGL is not linked by GLFW
+        void(GLAPP_GL_APIENTRY* flush_)() = nullptr;
+
+        bool loaded_ = false;
+        uint32_t framebuffer_ = 0;
+        // Color and depth-stencil
+        uint32_t renderbuffers_[2] = {};
+        glapp::size<int32_t> size_;
+
+    public:
+        // Returns false if the framebuffer object is not supported by the current context
+        bool load(int32_t context_version_major)
+        {
+            internal::load_gl_proc(flush_, "glFlush");
+            if (context_version_major < 3 && glfwExtensionSupported("GL_ARB_framebuffer_object") != GLFW_TRUE) {
+                return false;
+            }
+            internal::load_gl_proc(gen_framebuffers_, "glGenFramebuffers");
+            internal::load_gl_proc(delete_framebuffers_, "glDeleteFramebuffers");
+            internal::load_gl_proc(bind_framebuffer_, "glBindFramebuffer");
+            internal::load_gl_proc(check_framebuffer_status_, "glCheckFramebufferStatus");
+            internal::load_gl_proc(framebuffer_renderbuffer_, "glFramebufferRenderbuffer");
+            internal::load_gl_proc(gen_renderbuffers_, "glGenRenderbuffers");
+            internal::load_gl_proc(delete_renderbuffers_, "glDeleteRenderbuffers");
+            internal::load_gl_proc(bind_renderbuffer_, "glBindRenderbuffer");
+            internal::load_gl_proc(renderbuffer_storage_, "glRenderbufferStorage");
+            loaded_ = gen_framebuffers_ && delete_framebuffers_ && bind_framebuffer_ && check_framebuffer_status_ && framebuffer_renderbuffer_
+                && gen_renderbuffers_ && delete_renderbuffers_ && bind_renderbuffer_ && renderbuffer_storage_;
+            return loaded_;
+        }
+
+        uint32_t framebuffer() const { return framebuffer_; }
+
+        // Submits the commands without waiting for the presentation
+        void flush()
+        {
+            if (flush_) {
+                flush_();
+            }
+        }
+
+        // Binds the framebuffer object, which is reallocated when the size is changed
+        // Returns the name of the framebuffer object, or 0 if it could not be allocated
+        uint32_t bind(const glapp::size<int32_t>& size)
+        {
+            if (!loaded_ || size.width() <= 0 || size.height() <= 0) {
+                return 0;
+            }
+            if (framebuffer_ == 0 || size_.width() != size.width() || size_.height() != size.height()) {
+                allocate(size);
+            }
+            bind_framebuffer_(gl_framebuffer, framebuffer_);
+            return framebuffer_;
+        }
+
+    private:
+        void allocate(const glapp::size<int32_t>& size)
+        {
+            release();
+            gen_framebuffers_(1, &framebuffer_);
+            gen_renderbuffers_(2, renderbuffers_);
+            bind_renderbuffer_(gl_renderbuffer, renderbuffers_[0]);
+            renderbuffer_storage_(gl_renderbuffer, gl_rgba8, size.width(), size.height());
+            bind_renderbuffer_(gl_renderbuffer, renderbuffers_[1]);
+            renderbuffer_storage_(gl_renderbuffer, gl_depth24_stencil8, size.width(), size.height());
+            bind_renderbuffer_(gl_renderbuffer, 0);
+            bind_framebuffer_(gl_framebuffer, framebuffer_);
+            framebuffer_renderbuffer_(gl_framebuffer, gl_color_attachment0, gl_renderbuffer, renderbuffers_[0]);
+            framebuffer_renderbuffer_(gl_framebuffer, gl_depth_stencil_attachment, gl_renderbuffer, renderbuffers_[1]);
+            if (check_framebuffer_status_(gl_framebuffer) != gl_framebuffer_complete) {
+                bind_framebuffer_(gl_framebuffer, 0);
+                release();
+                // Do not retry every frame
+                loaded_ = false;
+                return;
+            }
+            size_ = size;
+        }
+
+        void release()
+        {
+            if (framebuffer_ != 0) {
+                delete_framebuffers_(1, &framebuffer_);
+                delete_renderbuffers_(2, renderbuffers_);
+                framebuffer_ = 0;
+                renderbuffers_[0] = renderbuffers_[1] = 0;
+            }
+        }
+    };
+
+    using capture_callback_t = std::function<void(const glapp::captured_frame&)>;
+    // Callbacks requested in the same frame, which share one read back
+    using capture_callbacks_t = std::vector<capture_callback_t>;
+
+    // Reads back the frames into a ring of pixel buffer objects, and delivers them on the worker thread after the fences are signaled
+    // The frame is dropped instead of stalling the pipeline while the ring or the queue of the worker thread is full
+    class frame_capturer : internal::noncopyable {
+    private:
+        static constexpr uint32_t gl_pixel_pack_buffer = 0x88EB;
+        static constexpr uint32_t gl_stream_read = 0x88E1;
+        static constexpr uint32_t gl_read_only = 0x88B8;
+        static constexpr uint32_t gl_read_framebuffer = 0x8CA8;
+        static constexpr uint32_t gl_sync_gpu_commands_complete = 0x9117;
+        static constexpr uint32_t gl_already_signaled = 0x911A;
+        static constexpr uint32_t gl_condition_satisfied = 0x911C;
+        // Number of frames in flight whose pixels are not read yet
+        static constexpr size_t frame_latency = 3;
+        // Number of frames waiting for the callback on the worker thread
+        static constexpr size_t max_queued_frames = 4;
+
+        void(GLAPP_GL_APIENTRY* gen_buffers_)(int32_t, uint32_t*) = nullptr;
+        void(GLAPP_GL_APIENTRY* bind_buffer_)(uint32_t, uint32_t) = nullptr;
+        void(GLAPP_GL_APIENTRY* buffer_data_)(uint32_t, std::ptrdiff_t, const void*, uint32_t) = nullptr;
+        void*(GLAPP_GL_APIENTRY* map_buffer_)(uint32_t, uint32_t) = nullptr;
+        uint8_t(GLAPP_GL_APIENTRY* unmap_buffer_)(uint32_t) = nullptr;
+        // GLsync is an opaque pointer
+        void*(GLAPP_GL_APIENTRY* fence_sync_)(uint32_t, uint32_t) = nullptr;
+        uint32_t(GLAPP_GL_APIENTRY* client_wait_sync_)(void*, uint32_t, uint64_t) = nullptr;
+        void(GLAPP_GL_APIENTRY* delete_sync_)(void*) = nullptr;
+        void(GLAPP_GL_APIENTRY* read_pixels_)(int32_t, int32_t, int32_t, int32_t, uint32_t, uint32_t, void*) = nullptr;
+        // Optional, to read the framebuffer object of the headless window
+        void(GLAPP_GL_APIENTRY* bind_framebuffer_)(uint32_t, uint32_t) = nullptr;
+
+        struct slot {
+            uint32_t buffer = 0;
+            size_t capacity = 0;
+            // Not null while the pixels are being read
+            void* fence = nullptr;
+            int64_t frame_count = 0;
+            int32_t width = 0;
+            int32_t height = 0;
+            capture_callbacks_t callbacks;
+        };
+
+        struct job {
+            std::vector<uint8_t> pixels;
+            int64_t frame_count;
+            int32_t width;
+            int32_t height;
+            capture_callbacks_t callbacks;
+        };
+
+        slot slots_[frame_latency];
+        // Index of the slot to be written next, which is the oldest one
+        size_t next_ = 0;
+        std::atomic<int64_t>& dropped_count_;
+
+        // Following members are shared with the worker thread
+        std::mutex mtx_;
+        std::condition_variable cv_;
+        std::vector<job> jobs_;
+        // Pixel storage reused after the callbacks
+        std::vector<std::vector<uint8_t>> free_pixels_;
+        bool stopping_ = false;
+        std::thread worker_;
+
+    public:
+        explicit frame_capturer(std::atomic<int64_t>& dropped_count)
+            : dropped_count_(dropped_count)
+        {
+        }
+
+        // Delivers the frames already read back before stopping the worker thread
+        // The frames still in flight are discarded, since the context may be no longer available
+        ~frame_capturer()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mtx_);
+                stopping_ = true;
+            }
+            cv_.notify_one();
+            if (worker_.joinable()) {
+                worker_.join();
+            }
+        }
+
+        // Returns false if the pixel buffer object or the fence is not supported by the current context
+        bool load(int32_t major, int32_t minor)
+        {
+            if ((major < 3 || (major == 3 && minor < 2))
+                && (glfwExtensionSupported("GL_ARB_sync") != GLFW_TRUE || glfwExtensionSupported("GL_ARB_pixel_buffer_object") != GLFW_TRUE)) {
+                return false;
+            }
+            internal::load_gl_proc(gen_buffers_, "glGenBuffers");
+            internal::load_gl_proc(bind_buffer_, "glBindBuffer");
+            internal::load_gl_proc(buffer_data_, "glBufferData");
+            internal::load_gl_proc(map_buffer_, "glMapBuffer");
+            internal::load_gl_proc(unmap_buffer_, "glUnmapBuffer");
+            internal::load_gl_proc(fence_sync_, "glFenceSync");
+            internal::load_gl_proc(client_wait_sync_, "glClientWaitSync");
+            internal::load_gl_proc(delete_sync_, "glDeleteSync");
+            internal::load_gl_proc(read_pixels_, "glReadPixels");
+            internal::load_gl_proc(bind_framebuffer_, "glBindFramebuffer");
+            return gen_buffers_ && bind_buffer_ && buffer_data_ && map_buffer_ && unmap_buffer_ && fence_sync_ && client_wait_sync_ && delete_sync_
+                && read_pixels_;
+        }
+
+        // Returns true while any frame is being read
+        bool pending() const
+        {
+            for (auto&& s : slots_) {
+                if (s.fence != nullptr) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Starts reading the framebuffer into the next pixel buffer object without waiting for it
+        // callbacks - taken by the slot, and left empty
+        void capture(int64_t frame_count, uint32_t framebuffer, int32_t width, int32_t height, capture_callbacks_t& callbacks)
+        {
+            auto& s = slots_[next_];
+            if (s.fence != nullptr || width <= 0 || height <= 0) {
+                dropped_count_ += static_cast<int64_t>(callbacks.size());
+                callbacks.clear();
+                return;
+            }
+            const size_t size = static_cast<size_t>(width) * static_cast<size_t>(height) * 4;
+            if (s.buffer == 0) {
+                gen_buffers_(1, &s.buffer);
+            }
+            bind_buffer_(gl_pixel_pack_buffer, s.buffer);
+            if (s.capacity != size) {
+                buffer_data_(gl_pixel_pack_buffer, static_cast<std::ptrdiff_t>(size), nullptr, gl_stream_read);
+                s.capacity = size;
+            }
+            if (bind_framebuffer_) {
+                bind_framebuffer_(gl_read_framebuffer, framebuffer);
+            }
+            read_pixels_(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            bind_buffer_(gl_pixel_pack_buffer, 0);
+            s.fence = fence_sync_(gl_sync_gpu_commands_complete, 0);
+            s.frame_count = frame_count;
+            s.width = width;
+            s.height = height;
+            // Swap to reuse the storage of the callbacks
+            s.callbacks.swap(callbacks);
+            callbacks.clear();
+            next_ = (next_ + 1) % frame_latency;
+        }
+
+        // Passes the frames whose fence is signaled to the worker thread in the order of capturing
+        void collect()
+        {
+            for (size_t i = 0; i < frame_latency; ++i) {
+                auto& s = slots_[(next_ + i) % frame_latency];
+                if (s.fence == nullptr) {
+                    continue;
+                }
+                const auto status = client_wait_sync_(s.fence, 0, 0);
+                if (status != gl_already_signaled && status != gl_condition_satisfied) {
+                    break;
+                }
+                delete_sync_(s.fence);
+                s.fence = nullptr;
+                bind_buffer_(gl_pixel_pack_buffer, s.buffer);
+                const void* pixels = map_buffer_(gl_pixel_pack_buffer, gl_read_only);
+                if (pixels != nullptr) {
+                    deliver(s, static_cast<const uint8_t*>(pixels));
+                    unmap_buffer_(gl_pixel_pack_buffer);
+                } else {
+                    dropped_count_ += static_cast<int64_t>(s.callbacks.size());
+                }
+                bind_buffer_(gl_pixel_pack_buffer, 0);
+                s.callbacks.clear();
+            }
+        }
 
-    // Returns the monitor size in millimetres (Aspect ratio is reflected)
-    glapp::size<int32_t> pysical_size() const
-    {
-        glapp::size<int32_t> size {};
-        if (handle_) {
-            int width {};
-            int height {};
-            glfwGetMonitorPhysicalSize(handle_->get(), &width, &height);
-            size = { width, height };
+    private:
+        void deliver(slot& s, const uint8_t* pixels)
+        {
+            job j { {}, s.frame_count, s.width, s.height, std::move(s.callbacks) };
+            {
+                std::lock_guard<std::mutex> lock(mtx_);
+                if (max_queued_frames <= jobs_.size()) {
+                    dropped_count_ += static_cast<int64_t>(j.callbacks.size());
+                    return;
+                }
+                if (!free_pixels_.empty()) {
+                    j.pixels = std::move(free_pixels_.back());
+                    free_pixels_.pop_back();
+                }
+            }
+            // Copy outside the lock, as the mapped buffer must be released on this thread
+            j.pixels.assign(pixels, pixels + s.capacity);
+            {
+                std::lock_guard<std::mutex> lock(mtx_);
+                jobs_.push_back(std::move(j));
+                if (!worker_.joinable()) {
+                    worker_ = std::thread(&frame_capturer::work, this);
+                }
+            }
+            cv_.notify_one();
         }
-        return size;
-    }
 
-    glapp::size<float> content_scale() const
-    {
-        glapp::size<float> scale {};
-        if (handle_) {
-            float xscale {};
-            float yscale {};
-            glfwGetMonitorContentScale(handle_->get(), &xscale, &yscale);
-            scale = { xscale, yscale };
+        void work()
+        {
+            internal::tracer::instance().set_thread_name("capture");
+            std::vector<job> jobs;
+            std::unique_lock<std::mutex> lock(mtx_);
+            while (true) {
+                cv_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+                if (jobs_.empty()) {
+                    break;
+                }
+                jobs.swap(jobs_);
+                lock.unlock();
+                for (auto&& j : jobs) {
+                    glapp::captured_frame frame;
+                    frame.frame_count_ = j.frame_count;
+                    frame.width_ = j.width;
+                    frame.height_ = j.height;
+                    frame.pixels_ = j.pixels.data();
+                    for (auto&& callback : j.callbacks) {
+                        callback(frame);
+                    }
+                }
+                lock.lock();
+                for (auto&& j : jobs) {
+                    free_pixels_.push_back(std::move(j.pixels));
+                }
+                jobs.clear();
+            }
         }
-        return scale;
-    }
+    };
 
-    glapp::monitor_mode current_mode() const
-    {
-        glapp::monitor_mode mode {};
-        if (handle_) {
-            auto glfw_mode = glfwGetVideoMode(handle_->get());
-            if (glfw_mode != nullptr) {
-                mode = glapp::monitor_mode(*glfw_mode);
+    // Measures GPU time with timer queries
+    // The results are read several frames later only if available, so that the pipeline never stalls
+    class gpu_timer : internal::noncopyable {
+    private:
+        static constexpr uint32_t gl_time_elapsed = 0x88BF;
+        static constexpr uint32_t gl_timestamp = 0x8E28;
+        static constexpr uint32_t gl_query_result = 0x8866;
+        static constexpr uint32_t gl_query_result_available = 0x8867;
+        // Number of frames in flight whose results are not read yet
+        static constexpr size_t frame_latency = 4;
+
+        void(GLAPP_GL_APIENTRY* gen_queries_)(int32_t, uint32_t*) = nullptr;
+        void(GLAPP_GL_APIENTRY* delete_queries_)(int32_t, const uint32_t*) = nullptr;
+        void(GLAPP_GL_APIENTRY* begin_query_)(uint32_t, uint32_t) = nullptr;
+        void(GLAPP_GL_APIENTRY* end_query_)(uint32_t) = nullptr;
+        void(GLAPP_GL_APIENTRY* query_counter_)(uint32_t, uint32_t) = nullptr;
+        void(GLAPP_GL_APIENTRY* get_query_objectiv_)(uint32_t, uint32_t, int32_t*) = nullptr;
+        void(GLAPP_GL_APIENTRY* get_query_objectui64v_)(uint32_t, uint32_t, uint64_t*) = nullptr;
+
+        struct zone {
+            const char* name;
+            int32_t depth;
+            // Indices of the timestamp queries
+            size_t begin_query;
+            size_t end_query;
+        };
+
+        struct frame {
+            int64_t frame_count = -1;
+            uint32_t elapsed_query = 0;
+            std::vector<uint32_t> timestamp_queries;
+            size_t timestamp_count = 0;
+            std::vector<zone> zones;
+        };
+
+        frame frames_[frame_latency];
+        size_t current_ = 0;
+        // Indices of the zones not ended yet in the current frame
+        std::vector<size_t> open_zones_;
+
+    public:
+        // Returns false if the timer query is not supported by the current context
+        bool load()
+        {
+            if (glfwExtensionSupported("GL_ARB_timer_query") != GLFW_TRUE) {
+                return false;
             }
+            internal::load_gl_proc(gen_queries_, "glGenQueries");
+            internal::load_gl_proc(delete_queries_, "glDeleteQueries");
+            internal::load_gl_proc(begin_query_, "glBeginQuery");
+            internal::load_gl_proc(end_query_, "glEndQuery");
+            internal::load_gl_proc(query_counter_, "glQueryCounter");
+            internal::load_gl_proc(get_query_objectiv_, "glGetQueryObjectiv");
+            internal::load_gl_proc(get_query_objectui64v_, "glGetQueryObjectui64v");
+            if (!gen_queries_ || !delete_queries_ || !begin_query_ || !end_query_ || !query_counter_ || !get_query_objectiv_ || !get_query_objectui64v_) {
+                return false;
+            }
+            for (auto&& f : frames_) {
+                gen_queries_(1, &f.elapsed_query);
+            }
+            return true;
         }
-        return mode;
-    }
 
-    std::vector<glapp::monitor_mode> supported_modes() const
-    {
-        std::vector<glapp::monitor_mode> modes {};
-        if (handle_) {
-            int count {};
-            auto glfw_modes = glfwGetVideoModes(handle_->get(), &count);
-            if (glfw_modes != nullptr) {
-                modes.reserve(count);
-                for (int i = 0; i < count; ++i) {
-                    modes.push_back(glapp::monitor_mode(glfw_modes[i]));
+        // Deletes the queries, which must be called while the context is current
+        void release()
+        {
+            if (delete_queries_ == nullptr) {
+                return;
+            }
+            for (auto&& f : frames_) {
+                delete_queries_(1, &f.elapsed_query);
+                if (!f.timestamp_queries.empty()) {
+                    delete_queries_(static_cast<int32_t>(f.timestamp_queries.size()), f.timestamp_queries.data());
                 }
             }
         }
-        return modes;
-    }
 
-    void set_user_pointer(void* pointer)
-    {
-        if (handle_) {
-            glfwSetMonitorUserPointer(handle_->get(), pointer);
-        }
-    }
-    void* user_pointer() const
-    {
-        void* pointer {};
-        if (handle_) {
-            pointer = glfwGetMonitorUserPointer(handle_->get());
+        // Reads the results of the frames already finished by GPU into 'timing', and starts measuring the frame
+        void begin_frame(int64_t frame_count, glapp::gpu_frame_timing& timing)
+        {
+            for (size_t i = 0; i < frame_latency; ++i) {
+                collect(frames_[(current_ + i) % frame_latency], timing);
+            }
+            auto& f = frames_[current_];
+            // Results of the frame not finished yet are discarded by reusing the queries
+            f.frame_count = frame_count;
+            f.timestamp_count = 0;
+            f.zones.clear();
+            open_zones_.clear();
+            begin_query_(gl_time_elapsed, f.elapsed_query);
         }
-        return pointer;
-    }
 
-private:
-    monitor(GLFWmonitor* glfw_monitor)
-        : handle_(std::make_shared<internal::glfw_monitor_handle>(glfw_monitor, nullptr))
-    {
-    }
+        void end_frame()
+        {
+            while (!open_zones_.empty()) {
+                end_zone();
+            }
+            end_query_(gl_time_elapsed);
+            current_ = (current_ + 1) % frame_latency;
+        }
 
-    void destroy()
-    {
-        if (handle_) {
-            handle_.reset();
+        // name - must be valid until the result is read, such as a string literal
+        void begin_zone(const char* name)
+        {
+            auto& f = frames_[current_];
+            open_zones_.push_back(f.zones.size());
+            f.zones.push_back({ name, static_cast<int32_t>(open_zones_.size()) - 1, timestamp(f), 0 });
         }
-    }
-};
 
-enum class window_state {
-    normal,
-    minimized,
-    maximized,
-    fullscreen
-};
+        void end_zone()
+        {
+            if (open_zones_.empty()) {
+                return;
+            }
+            auto& f = frames_[current_];
+            f.zones[open_zones_.back()].end_query = timestamp(f);
+            open_zones_.pop_back();
+        }
 
-class window : internal::noncopyable {
-    friend class app;
+    private:
+        // Records the timestamp and returns the index of the query
+        size_t timestamp(frame& f)
+        {
+            if (f.timestamp_count == f.timestamp_queries.size()) {
+                uint32_t query = 0;
+                gen_queries_(1, &query);
+                f.timestamp_queries.push_back(query);
+            }
+            query_counter_(f.timestamp_queries[f.timestamp_count], gl_timestamp);
+            return f.timestamp_count++;
+        }
 
-private:
-    std::shared_ptr<internal::glfw_window_handle> handle_;
-    std::string title_;
-    std::string title_original_;
-    std::string tag_;
-    int32_t swap_interval_ = 0;
-    int32_t last_swap_interval_ = INT32_MAX;
-    void* user_pointer_ {};
-    int64_t frame_count_ = 0;
-    glapp::rect<int32_t> normal_window_rect_;
-    glapp::rect<int32_t> fullscreen_backup_window_rect_;
-    glapp::size<int32_t> size_limit_min_;
-    glapp::size<int32_t> size_limit_max_;
-    glapp::size<int32_t> aspect_ratio_;
+        void collect(frame& f, glapp::gpu_frame_timing& timing)
+        {
+            if (f.frame_count < 0 || f.frame_count <= timing.frame_count_) {
+                return;
+            }
+            int32_t available = 0;
+            // The timestamps of the zones are recorded before ending the elapsed time query
+            get_query_objectiv_(f.elapsed_query, gl_query_result_available, &available);
+            if (available == 0) {
+                return;
+            }
+            uint64_t elapsed = 0;
+            get_query_objectui64v_(f.elapsed_query, gl_query_result, &elapsed);
+            timing.frame_count_ = f.frame_count;
+            timing.frame_time_ = elapsed * 1e-9;
+            timing.zones_.resize(f.zones.size());
+            for (size_t i = 0; i < f.zones.size(); ++i) {
+                uint64_t begin = 0;
+                uint64_t end = 0;
+                get_query_objectui64v_(f.timestamp_queries[f.zones[i].begin_query], gl_query_result, &begin);
+                get_query_objectui64v_(f.timestamp_queries[f.zones[i].end_query], gl_query_result, &end);
+                auto& zone = timing.zones_[i];
+                zone.name_ = f.zones[i].name;
+                zone.depth_ = f.zones[i].depth;
+                zone.duration_ = (begin < end) ? (end - begin) * 1e-9 : 0.0;
+            }
+        }
+    };
 
+    // Callbacks subscribed to an event
+    // Callbacks may be added or removed while dispatching, added ones are called from the next dispatch
     template <typename... Args>
     class event {
     private:
-        std::function<void(Args...)> callback_;
+        struct subscriber {
+            // Zero while the removal is deferred until the end of dispatching
+            uint64_t id;
+            internal::delegate<void(Args...)> callback;
+        };
+        // Each subscriber is allocated separately so that the running callback is not moved by adding another
+        std::vector<std::unique_ptr<subscriber>> subscribers_;
+        int32_t dispatch_depth_ = 0;
+        bool removal_pending_ = false;
 
     public:
         template <typename T>
-        void set_callback(T&& callback)
+        void add(uint64_t id, T&& callback)
+        {
+            subscribers_.emplace_back(new subscriber { id, internal::delegate<void(Args...)>(std::forward<T>(callback)) });
+        }
+
+        bool remove(uint64_t id)
+        {
+            auto it = std::find_if(subscribers_.begin(), subscribers_.end(), [id](const std::unique_ptr<subscriber>& s) { return s->id == id; });
+            if (id == 0 || it == subscribers_.end()) {
+                return false;
+            }
+            if (dispatch_depth_ > 0) {
+                (*it)->id = 0;
+                removal_pending_ = true;
+            } else {
+                subscribers_.erase(it);
+            }
+            return true;
+        }
+
+        void clear()
         {
-            callback_ = std::forward<T>(callback);
+            if (dispatch_depth_ > 0) {
+                for (auto&& s : subscribers_) {
+                    s->id = 0;
+                }
+                removal_pending_ = true;
+            } else {
+                subscribers_.clear();
+            }
         }
 
         void operator()(Args... args)
         {
-            if (callback_) {
-                callback_(args...);
+            ++dispatch_depth_;
+            for (size_t i = 0, count = subscribers_.size(); i < count; ++i) {
+                auto& s = *subscribers_[i];
+                if (s.id != 0) {
+                    s.callback(args...);
+                }
+            }
+            if (--dispatch_depth_ == 0 && removal_pending_) {
+                subscribers_.erase(
+                    std::remove_if(subscribers_.begin(), subscribers_.end(), [](const std::unique_ptr<subscriber>& s) { return s->id == 0; }),
+                    subscribers_.end());
+                removal_pending_ = false;
             }
         }
+
+        explicit operator bool() const { return !subscribers_.empty(); }
     };
 
-    event<window&> frame_event;
-    event<window&, const std::string&, const glapp::key_state&, const glapp::modifier&> key_event;
-    event<window&, const std::string&, const glapp::button_state&, const glapp::modifier&> mouse_button_event;
+    event<window&, double> frame_event;
+    event<window&, double> update_event;
+    event<window&, glapp::key, const glapp::key_state&, const glapp::modifier&> key_event;
+    event<window&, glapp::mouse_button, const glapp::button_state&, const glapp::modifier&> mouse_button_event;
     event<window&, double, double> cursor_pos_event;
     event<window&, bool> cursor_enter_event;
     event<window&, double, double> scroll_event;
@@ -779,7 +2838,14 @@ private:
     event<window&, glapp::window_state> window_state_event;
     event<window&, float, float> window_contentscale_event;
     event<window&, int32_t, int32_t> framebuffer_size_event;
-    event<window&, const std::vector<std::string>&> drop_event;
+    event<window&, const glapp::path_span&> drop_event;
+
+    // Following members are accessed only by the drawing thread
+    std::unique_ptr<gpu_timer> gpu_timer_;
+    glapp::gpu_frame_timing gpu_timing_;
+    std::unique_ptr<offscreen_target> offscreen_target_;
+    std::unique_ptr<frame_capturer> frame_capturer_;
+    capture_callbacks_t capture_callbacks_;
 
     // Folloing member is valid only for reference instance
     std::weak_ptr<window> weakref_;
@@ -789,6 +2855,7 @@ public:
 
     ~window()
     {
+        stop_render_thread();
         if (handle_) {
             handle_.reset();
         }
@@ -800,6 +2867,96 @@ public:
 
     int64_t frame_count() const { return frame_count_; }
 
+    // Returns the timing statistics of the recent frames
+    glapp::frame_stats frame_stats() const
+    {
+        float cpu_times[frame_sample_capacity];
+        float swap_times[frame_sample_capacity];
+        float intervals[frame_sample_capacity];
+        size_t count = 0;
+        size_t interval_count = 0;
+        glapp::frame_stats stats;
+        {
+            std::lock_guard<std::mutex> lock(frame_stats_mtx_);
+            // Pass the capacity by value, since binding the reference to it requires the definition before C++17
+            count = (std::min)(frame_sample_count_, size_t { frame_sample_capacity });
+            for (size_t i = 0; i < count; ++i) {
+                cpu_times[i] = frame_samples_[i].cpu_time;
+                swap_times[i] = frame_samples_[i].swap_time;
+                if (0.0f <= frame_samples_[i].interval) {
+                    intervals[interval_count++] = frame_samples_[i].interval;
+                }
+            }
+            stats.dropped_frames_ = dropped_frame_count_;
+        }
+        stats.sample_count_ = count;
+        stats.cpu_time_ = glapp::duration_stats(cpu_times, count);
+        stats.swap_time_ = glapp::duration_stats(swap_times, count);
+        stats.interval_ = glapp::duration_stats(intervals, interval_count);
+        return stats;
+    }
+
+    // Enables measuring the GPU time of each frame by the timer queries (GL_ARB_timer_query)
+    // It is disabled on the next frame if the context does not support them
+    void set_gpu_timing(bool enabled) { gpu_timing_enabled_ = enabled; }
+    bool gpu_timing_enabled() const { return gpu_timing_enabled_; }
+
+    // ATTENTION: This function must be called inside 'on_frame' callback
+    // Returns the GPU timing of the latest frame whose result is available
+    const glapp::gpu_frame_timing& gpu_timing() const { return gpu_timing_; }
+
+    // ATTENTION: This function must be called inside 'on_frame' callback
+    // Begins the zone to measure the GPU time, which can be nested
+    // name - must be valid until the result is available, such as a string literal
+    void begin_gpu_zone(const char* name)
+    {
+        if (gpu_timer_) {
+            gpu_timer_->begin_zone(name);
+        }
+    }
+
+    // ATTENTION: This function must be called inside 'on_frame' callback
+    // Ends the zone begun by 'begin_gpu_zone' last
+    void end_gpu_zone()
+    {
+        if (gpu_timer_) {
+            gpu_timer_->end_zone();
+        }
+    }
+
+    // ATTENTION: This function must be called inside 'on_frame' callback
+    // Reads back the frame after the 'on_frame' callbacks without stalling, and delivers it a few frames later
+    // The callback is called on the worker thread of the window, with the arguments (const glapp::captured_frame& frame)
+    // The callbacks requested in the same frame, such as by 'recorder' and 'frame_exporter', share one read back
+    // The frame is dropped if too many frames are in flight, see 'dropped_capture_count'
+    // Returns false if the context does not support the pixel buffer object and the fence (OpenGL 3.2 or GL_ARB_sync)
+    template <typename T>
+    bool capture_async(T callback)
+    {
+        if (!handle_) {
+            return false;
+        }
+        if (!frame_capturer_) {
+            frame_capturer_.reset(new frame_capturer(dropped_capture_count_));
+            capture_supported_ = frame_capturer_->load(context_version_major_, context_version_minor_);
+        }
+        if (capture_supported_) {
+            capture_callbacks_.emplace_back(std::move(callback));
+        }
+        return capture_supported_;
+    }
+
+    // Returns the number of the frames requested by 'capture_async' but dropped, counted for each callback
+    int64_t dropped_capture_count() const { return dropped_capture_count_; }
+
+    // Returns true if the window is created by 'app::add_headless_window' or 'window_options::set_headless'
+    bool headless() const { return headless_; }
+
+    // ATTENTION: This function must be called inside 'on_frame' callback
+    // Returns the name of the framebuffer object which the frame is drawn into,
+    // or 0 for the default framebuffer, also when the headless window could not allocate the framebuffer object
+    uint32_t framebuffer_id() const { return offscreen_target_ ? offscreen_target_->framebuffer() : 0; }
+
     void set_resizable(bool resizable)
     {
         if (handle_) {
@@ -834,15 +2991,14 @@ public:
 
     void set_pos(const glapp::point<int32_t>& pos)
     {
-        if (handle_) {
-            glfwSetWindowPos(handle_->get(), pos.x(), pos.y());
-        }
+        set_pos(pos.x(), pos.y());
     }
 
     void set_pos(int32_t xpos, int32_t ypos)
     {
         if (handle_) {
             glfwSetWindowPos(handle_->get(), xpos, ypos);
+            refresh_cache();
         }
     }
 
@@ -851,7 +3007,7 @@ public:
         int32_t xpos = 0;
         int32_t ypos = 0;
         if (handle_) {
-            glfwGetWindowPos(handle_->get(), &xpos, &ypos);
+            pos_cache_.load(xpos, ypos);
         }
         return { xpos, ypos };
     }
@@ -871,7 +3027,7 @@ public:
         int32_t width = 0;
         int32_t height = 0;
         if (handle_) {
-            glfwGetWindowSize(handle_->get(), &width, &height);
+            size_cache_.load(width, height);
         }
         return { width, height };
     }
@@ -915,6 +3071,7 @@ public:
         if (handle_) {
             aspect_ratio_ = glapp::size<int32_t>(numerator, denominator);
             glfwSetWindowAspectRatio(handle_->get(), numerator, denominator);
+            refresh_cache();
         }
     }
 
@@ -924,6 +3081,7 @@ public:
         if (handle_) {
             aspect_ratio_ = {};
             glfwSetWindowAspectRatio(handle_->get(), GLFW_DONT_CARE, GLFW_DONT_CARE);
+            refresh_cache();
         }
     }
 
@@ -932,7 +3090,7 @@ public:
         int32_t framebuffer_width = 0;
         int32_t framebuffer_height = 0;
         if (handle_) {
-            glfwGetFramebufferSize(handle_->get(), &framebuffer_width, &framebuffer_height);
+            framebuffer_size_cache_.load(framebuffer_width, framebuffer_height);
         }
         return { framebuffer_width, framebuffer_height };
     }
@@ -942,7 +3100,7 @@ public:
         float xscale = 0.0f;
         float yscale = 0.0f;
         if (handle_) {
-            glfwGetWindowContentScale(handle_->get(), &xscale, &yscale);
+            contentscale_cache_.load(xscale, yscale);
         }
         return { xscale, yscale };
     }
@@ -969,6 +3127,7 @@ public:
     {
         if (handle_) {
             glfwIconifyWindow(handle_->get());
+            refresh_cache();
         }
     }
 
@@ -977,14 +3136,18 @@ public:
     void maximize()
     {
         if (handle_) {
-            if (glfwGetWindowMonitor(handle_->get()) != nullptr) {
-                if (state_internal() == glapp::window_state::minimized) {
+            auto glfw_monitor = glfwGetWindowMonitor(handle_->get());
+            if (glfw_monitor != nullptr) {
+                if (query_state() == glapp::window_state::minimized) {
                     // Allows back to normal size when restoring from maximized
                     glfwRestoreWindow(handle_->get());
                 }
                 glfwSetWindowMonitor(handle_->get(), NULL, fullscreen_backup_window_rect_.x(), fullscreen_backup_window_rect_.y(), fullscreen_backup_window_rect_.width(), fullscreen_backup_window_rect_.height(), 0);
+                // The video mode of the monitor is restored
+                refresh_monitor(glfw_monitor);
             }
             glfwMaximizeWindow(handle_->get());
+            refresh_cache();
         }
     }
 
@@ -1005,15 +3168,20 @@ public:
     void restore()
     {
         if (handle_) {
-            if (glfwGetWindowMonitor(handle_->get()) != nullptr) {
-                if (state_internal() == glapp::window_state::minimized) {
+            auto glfw_monitor = glfwGetWindowMonitor(handle_->get());
+            if (glfw_monitor != nullptr) {
+                if (query_state() == glapp::window_state::minimized) {
                     // Return to fullscreen once by this call,
                     // to avoid restoring to maximum size
                     glfwRestoreWindow(handle_->get());
                 }
-                glfwSetWindowMonitor(handle_->get(), NULL, normal_window_rect_.x(), normal_window_rect_.y(), normal_window_rect_.width(), normal_window_rect_.height(), 0);
+                const auto rect = normal_window_rect();
+                glfwSetWindowMonitor(handle_->get(), NULL, rect.x(), rect.y(), rect.width(), rect.height(), 0);
+                // The video mode of the monitor is restored
+                refresh_monitor(glfw_monitor);
             }
             glfwRestoreWindow(handle_->get());
+            refresh_cache();
         }
     }
 
@@ -1028,7 +3196,7 @@ public:
         return placed_monitor_internal();
     }
 
-    void set_visible(bool visible) const
+    void set_visible(bool visible)
     {
         if (handle_) {
             if (visible) {
@@ -1036,6 +3204,8 @@ public:
             } else {
                 glfwHideWindow(handle_->get());
             }
+            hidden_ = !visible;
+            invalidate();
         }
     }
 
@@ -1087,12 +3257,96 @@ public:
     }
     int32_t swap_interval() { return swap_interval_; }
 
+    // Limits the frame rate of this window
+    // The frames are paced to the specified rate and the drawing thread sleeps in between
+    // fps - frames per second, 0 for unlimited
+    void set_target_fps(double fps)
+    {
+        target_fps_ = (0.0 < fps) ? fps : 0.0;
+        wake_drawing_thread();
+    }
+    double target_fps() const { return target_fps_; }
+
+    // Specifies the rate of the fixed time step updates by 'on_update'
+    // hz - updates per second, 0 to disable the updates
+    void set_update_rate(double hz)
+    {
+        update_rate_ = (0.0 < hz) ? hz : 0.0;
+    }
+    double update_rate() const { return update_rate_; }
+
+    // Limits the number of updates in a frame to avoid the spiral of death on slow machines
+    // The simulation slows down instead when it exceeds the limit
+    void set_max_updates_per_frame(int32_t count)
+    {
+        max_updates_per_frame_ = (std::max)(count, 1);
+    }
+    int32_t max_updates_per_frame() const { return max_updates_per_frame_; }
+
+    void set_render_mode(glapp::render_mode mode)
+    {
+        render_mode_ = mode;
+        invalidate();
+    }
+    glapp::render_mode render_mode() const { return render_mode_; }
+
+    // Specifies how to throttle the drawing while the window is minimized, hidden or unfocused
+    // The drawing stops while minimized or hidden by default, and resumes when the window is restored or shown
+    void set_throttle_policy(const glapp::throttle_policy& policy)
+    {
+        pause_when_minimized_ = policy.pause_when_minimized();
+        pause_when_hidden_ = policy.pause_when_hidden();
+        unfocused_fps_ = policy.unfocused_fps();
+        invalidate();
+    }
+    glapp::throttle_policy throttle_policy() const
+    {
+        return glapp::throttle_policy()
+            .set_pause_when_minimized(pause_when_minimized_)
+            .set_pause_when_hidden(pause_when_hidden_)
+            .set_unfocused_fps(unfocused_fps_);
+    }
+
+    // Returns true while the drawing is stopped by the throttle policy
+    bool paused() const
+    {
+        if (headless_) {
+            return false;
+        }
+        return (pause_when_minimized_ && state_cache_ == glapp::window_state::minimized) || (pause_when_hidden_ && hidden_);
+    }
+
+    // Requests to draw the next frame in `glapp::render_mode::on_demand`
+    // This function can be called from any thread
+    void invalidate()
+    {
+        invalidated_ = true;
+        // Wake up the event loop waiting for events, or the thread waiting for the next frame
+        glfwPostEmptyEvent();
+        wake_drawing_thread();
+    }
+
+    // Specifies how to coalesce the high rate events such as mouse moving and resizing
+    // The coalesced events are delivered once at the start of the next frame
+    // Other events such as key and mouse button are always delivered one by one
+    void set_coalescing(glapp::coalescible_event event, glapp::coalescing policy)
+    {
+        coalescing_[static_cast<size_t>(event)] = policy;
+    }
+    glapp::coalescing coalescing(glapp::coalescible_event event) const
+    {
+        return coalescing_[static_cast<size_t>(event)];
+    }
+
     void set_user_pointer(void* pointer) { user_pointer_ = pointer; }
     void* user_pointer() const { return user_pointer_; }
 
     void set_tag(const char* tag) { tag_ = tag; }
     const std::string& tag() const { return tag_; }
 
+    // Returns the identifier of the window in the trace, see 'app::start_trace'
+    uint32_t trace_id() const { return trace_id_; }
+
     void set_cursor_mode(glapp::cursor_mode mode) const
     {
         if (handle_) {
@@ -1142,6 +3396,10 @@ public:
         return ypos;
     }
 
+    // ATTENTION: This function must be called inside 'on_frame' callback
+    // Returns the input state taken at the start of the current frame
+    const glapp::input_state& input() const { return input_; }
+
     void set_clipboard_string(const char* str)
     {
         if (handle_) {
@@ -1171,6 +3429,9 @@ public:
     {
         if (handle_) {
             glfwSetWindowShouldClose(handle_->get(), GLFW_TRUE);
+            // Wake up the event loop waiting for events to destroy the window
+            glfwPostEmptyEvent();
+            wake_drawing_thread();
         }
     }
 
@@ -1201,63 +3462,121 @@ public:
 
     // clang-format off
 
-    // (glapp::window& window)
-    template <typename... Args> void on_frame(Args... args) { frame_event.set_callback(args...); }
+    // Following functions add the callback to the event and return the token to remove it by 'unsubscribe'
+    // Multiple callbacks can be subscribed to an event and they are called in the order of subscription
+    // Passing nullptr removes all the callbacks of the event, so that 'on_*(nullptr)' followed by 'on_*(callback)' replaces them
+
+    // (glapp::window& window) or (glapp::window& window, double alpha)
+    // alpha - interpolation factor in [0, 1) between the last update and the next update by 'on_update'
+    template <typename T> glapp::subscription on_frame(T callback) { return set_frame_callback(callback, 0); }
 
-    // (glapp::window& window, const std::string& key_name, const glapp::key_state& state, const glapp::modifier& modifier)
-    // key_name - see the 'key_to_name' function
-    template <typename... Args> void on_key(Args... args) { key_event.set_callback(args...); }
+    // (glapp::window& window, double dt)
+    // dt - fixed time step in seconds, see 'set_update_rate'
+    template <typename T> glapp::subscription on_update(T callback) { return subscribe(update_event, callback); }
 
-    // (glapp::window& window, const std::string& button_name, const glapp::button_state& state, const glapp::modifier& modifier)
+    // (glapp::window& window, glapp::key key, const glapp::key_state& state, const glapp::modifier& modifier)
+    // or (glapp::window& window, const std::string& key_name, const glapp::key_state& state, const glapp::modifier& modifier)
+    // key_name - see the 'key_name' function
+    template <typename T> glapp::subscription on_key(T callback) { install_glfw_callback(event_type::key); return set_key_callback(callback, 0); }
+
+    // (glapp::window& window, glapp::mouse_button button, const glapp::button_state& state, const glapp::modifier& modifier)
+    // or (glapp::window& window, const std::string& button_name, const glapp::button_state& state, const glapp::modifier& modifier)
     // button_name - 'left', 'right', 'middle'
-    template <typename... Args> void on_mouse_button(Args... args) { mouse_button_event.set_callback(args...); }
+    template <typename T> glapp::subscription on_mouse_button(T callback) { install_glfw_callback(event_type::mouse_button); return set_mouse_button_callback(callback, 0); }
 
     // (glapp::window& window, double x, double y)
-    template <typename... Args> void on_mouse_pos(Args... args) { cursor_pos_event.set_callback(args...); }
+    template <typename T> glapp::subscription on_mouse_pos(T callback) { install_glfw_callback(event_type::cursor_pos); return subscribe(cursor_pos_event, callback); }
 
     // (glapp::window& window, bool entered)
-    template <typename... Args> void on_mouse_enter(Args... args) { cursor_enter_event.set_callback(args...); }
+    template <typename T> glapp::subscription on_mouse_enter(T callback) { install_glfw_callback(event_type::cursor_enter); return subscribe(cursor_enter_event, callback); }
 
     // (glapp::window& window, double xoffset, double yoffset)
-    template <typename... Args> void on_mouse_wheel(Args... args) { scroll_event.set_callback(args...); }
+    template <typename T> glapp::subscription on_mouse_wheel(T callback) { install_glfw_callback(event_type::scroll); return subscribe(scroll_event, callback); }
 
     // (glapp::window& window, int32_t x, int32_t y)
-    template <typename... Args> void on_window_pos(Args... args) { window_pos_event.set_callback(args...); }
+    template <typename T> glapp::subscription on_window_pos(T callback) { return subscribe(window_pos_event, callback); }
 
     // (glapp::window& window, int32_t width, int32_t height)
-    template <typename... Args> void on_window_size(Args... args) { window_size_event.set_callback(args...); }
+    template <typename T> glapp::subscription on_window_size(T callback) { return subscribe(window_size_event, callback); }
 
     // (glapp::window& window)
-    template <typename... Args> void on_window_close(Args... args) { window_close_event.set_callback(args...); }
+    // Called on the main thread also in 'run_mode::drawing_thread' and 'run_mode::thread_per_window',
+    // and closing can be canceled by 'glfwSetWindowShouldClose(window.glfw_handle(), GLFW_FALSE)'
+    template <typename T> glapp::subscription on_window_close(T callback) { install_glfw_callback(event_type::window_close); return subscribe(window_close_event, callback); }
 
     // (glapp::window& window)
-    template <typename... Args> void on_window_redraw(Args... args) { window_refresh_event.set_callback(args...); }
+    template <typename T> glapp::subscription on_window_redraw(T callback) { return subscribe(window_refresh_event, callback); }
 
     // (glapp::window& window, bool focused)
-    template <typename... Args> void on_window_focus(Args... args) { window_focus_event.set_callback(args...); }
+    template <typename T> glapp::subscription on_window_focus(T callback) { return subscribe(window_focus_event, callback); }
 
     // (glapp::window& window, glapp::window_state state)
-    template <typename... Args> void on_window_state(Args... args) { window_state_event.set_callback(args...); }
+    template <typename T> glapp::subscription on_window_state(T callback) { return subscribe(window_state_event, callback); }
 
     // (glapp::window& window, float xscale, float yscale)
-    template <typename... Args> void on_window_contentscale(Args... args) { window_contentscale_event.set_callback(args...); }
+    template <typename T> glapp::subscription on_window_contentscale(T callback) { return subscribe(window_contentscale_event, callback); }
 
     // (glapp::window& window, int32_t width, int32_t height)
-    template <typename... Args> void on_framebuffer_size(Args... args) { framebuffer_size_event.set_callback(args...); }
-
-    // (glapp::window& window, int32_t count, const std::string& paths[])
-    template <typename... Args> void on_drop(Args... args) { drop_event.set_callback(args...); }
+    template <typename T> glapp::subscription on_framebuffer_size(T callback) { return subscribe(framebuffer_size_event, callback); }
+
+    // (glapp::window& window, const glapp::path_span& paths)
+    // or (glapp::window& window, const std::vector<std::string>& paths)
+    // The former receives the paths without copying them, and they are valid only during the callback
+    template <typename T> glapp::subscription on_drop(T callback) { install_glfw_callback(event_type::drop); return set_drop_callback(callback, 0); }
+
+    glapp::subscription on_frame(std::nullptr_t) { frame_event.clear(); return {}; }
+    glapp::subscription on_update(std::nullptr_t) { update_event.clear(); return {}; }
+    glapp::subscription on_key(std::nullptr_t) { key_event.clear(); return {}; }
+    glapp::subscription on_mouse_button(std::nullptr_t) { mouse_button_event.clear(); return {}; }
+    glapp::subscription on_mouse_pos(std::nullptr_t) { cursor_pos_event.clear(); return {}; }
+    glapp::subscription on_mouse_enter(std::nullptr_t) { cursor_enter_event.clear(); return {}; }
+    glapp::subscription on_mouse_wheel(std::nullptr_t) { scroll_event.clear(); return {}; }
+    glapp::subscription on_window_pos(std::nullptr_t) { window_pos_event.clear(); return {}; }
+    glapp::subscription on_window_size(std::nullptr_t) { window_size_event.clear(); return {}; }
+    glapp::subscription on_window_close(std::nullptr_t) { window_close_event.clear(); return {}; }
+    glapp::subscription on_window_redraw(std::nullptr_t) { window_refresh_event.clear(); return {}; }
+    glapp::subscription on_window_focus(std::nullptr_t) { window_focus_event.clear(); return {}; }
+    glapp::subscription on_window_state(std::nullptr_t) { window_state_event.clear(); return {}; }
+    glapp::subscription on_window_contentscale(std::nullptr_t) { window_contentscale_event.clear(); return {}; }
+    glapp::subscription on_framebuffer_size(std::nullptr_t) { framebuffer_size_event.clear(); return {}; }
+    glapp::subscription on_drop(std::nullptr_t) { drop_event.clear(); return {}; }
 
     // clang-format on
 
+    // Removes the callback added by the 'on_*' function
+    // Returns false if the callback has already been removed
+    // The GLFW callback installed for the event is kept even if there is no more subscriber
+    bool unsubscribe(const glapp::subscription& subscription)
+    {
+        const auto id = subscription.id_;
+        return frame_event.remove(id)
+            || update_event.remove(id)
+            || key_event.remove(id)
+            || mouse_button_event.remove(id)
+            || cursor_pos_event.remove(id)
+            || cursor_enter_event.remove(id)
+            || scroll_event.remove(id)
+            || window_pos_event.remove(id)
+            || window_size_event.remove(id)
+            || window_close_event.remove(id)
+            || window_refresh_event.remove(id)
+            || window_focus_event.remove(id)
+            || window_state_event.remove(id)
+            || window_contentscale_event.remove(id)
+            || framebuffer_size_event.remove(id)
+            || drop_event.remove(id);
+    }
+
 private:
     window(int32_t width, int32_t height, const char* title, const std::shared_ptr<glapp::monitor> monitor, const glapp::window_options& options)
         : title_(internal::or_empty(title))
         , title_original_(title_)
+        , trace_id_(next_trace_id())
+        , headless_(options.headless_)
     {
         glapp::window_options actual_options = options;
         GLFWwindow* glfw_window = nullptr;
-        if (monitor) {
+        if (monitor && !headless_) {
             const auto& mode = monitor->current_mode();
             actual_options.set_framebuffer_red_bits(mode.red_bits());
             actual_options.set_framebuffer_green_bits(mode.green_bits());
@@ -1286,30 +3605,108 @@ private:
         }
 
         glfwSetWindowUserPointer(glfw_window, this);
-        setup_callbacks(glfw_window);
+        setup_callbacks();
+        refresh_cache();
+        context_version_major_ = glfwGetWindowAttrib(glfw_window, GLFW_CONTEXT_VERSION_MAJOR);
+        context_version_minor_ = glfwGetWindowAttrib(glfw_window, GLFW_CONTEXT_VERSION_MINOR);
+        glfwGetCursorPos(glfw_window, &live_input_.cursor_x_, &live_input_.cursor_y_);
 
         if (state_internal() == glapp::window_state::normal) {
-            normal_window_rect_ = current_window_rect();
+            store_normal_window_rect(current_window_rect());
         } else {
             const auto monitor = placed_monitor_internal();
             assert(monitor);
             const auto rect = monitor->rect();
-            normal_window_rect_ = glapp::rect<int32_t>(
+            store_normal_window_rect(glapp::rect<int32_t>(
                 rect.left() + rect.width() / 4,
                 rect.top() + rect.height() / 4,
                 rect.width() / 2,
-                rect.height() / 2);
+                rect.height() / 2));
         }
     }
 
+    template <typename E, typename T>
+    glapp::subscription subscribe(E& event, T&& callback)
+    {
+        const auto id = next_subscription_id();
+        event.add(id, std::forward<T>(callback));
+        return glapp::subscription(id);
+    }
+
+    template <typename T>
+    auto set_frame_callback(T callback, int) -> decltype(callback(std::declval<glapp::window&>(), 0.0), glapp::subscription())
+    {
+        return subscribe(frame_event, std::move(callback));
+    }
+
+    template <typename T>
+    glapp::subscription set_frame_callback(T callback, long)
+    {
+        return subscribe(frame_event, [callback](glapp::window& window, double) mutable { callback(window); });
+    }
+
+    template <typename T>
+    auto set_key_callback(T callback, int) -> decltype(callback(std::declval<glapp::window&>(), glapp::key {}, std::declval<const glapp::key_state&>(), std::declval<const glapp::modifier&>()), glapp::subscription())
+    {
+        return subscribe(key_event, std::move(callback));
+    }
+
+    template <typename T>
+    glapp::subscription set_key_callback(T callback, long)
+    {
+        return subscribe(key_event, [callback](glapp::window& window, glapp::key key, const glapp::key_state& state, const glapp::modifier& modifier) mutable {
+            callback(window, glapp::key_name(key), state, modifier);
+        });
+    }
+
+    template <typename T>
+    auto set_mouse_button_callback(T callback, int) -> decltype(callback(std::declval<glapp::window&>(), glapp::mouse_button {}, std::declval<const glapp::button_state&>(), std::declval<const glapp::modifier&>()), glapp::subscription())
+    {
+        return subscribe(mouse_button_event, std::move(callback));
+    }
+
+    template <typename T>
+    glapp::subscription set_mouse_button_callback(T callback, long)
+    {
+        return subscribe(mouse_button_event, [callback](glapp::window& window, glapp::mouse_button button, const glapp::button_state& state, const glapp::modifier& modifier) mutable {
+            callback(window, glapp::mouse_button_name(button), state, modifier);
+        });
+    }
+
+    template <typename T>
+    auto set_drop_callback(T callback, int) -> decltype(callback(std::declval<glapp::window&>(), std::declval<const glapp::path_span&>()), glapp::subscription())
+    {
+        return subscribe(drop_event, std::move(callback));
+    }
+
+    template <typename T>
+    glapp::subscription set_drop_callback(T callback, long)
+    {
+        return subscribe(drop_event, [callback](glapp::window& window, const glapp::path_span& paths) mutable {
+            callback(window, std::vector<std::string>(paths.begin(), paths.end()));
+        });
+    }
+
     void destroy()
     {
+        // The context must be released by the render thread before the window is destroyed
+        stop_render_thread();
+        // Deliver the rest of events such as closing
+        process_queued_events();
+        // Deliver the frames already read back
+        frame_capturer_.reset();
         if (handle_) {
             handle_.reset();
         }
     }
 
     glapp::window_state state_internal() const
+    {
+        return handle_ ? state_cache_.load() : glapp::window_state::normal;
+    }
+
+    // Queries the window state to GLFW instead of the cache
+    glapp::window_state query_state() const
     {
         glapp::window_state state = glapp::window_state::normal;
         if (handle_) {
@@ -1340,37 +3737,43 @@ private:
             } else {
             }
             glfwSetWindowSize(handle_->get(), w, h);
+            refresh_cache();
         }
     }
 
     void fullscreen_internal(const std::shared_ptr<glapp::monitor> monitor)
     {
         if (handle_ && monitor) {
-            auto current_state = state_internal();
+            auto current_state = query_state();
             if (current_state == glapp::window_state::minimized && glfwGetWindowMonitor(handle_->get()) != nullptr) {
                 glfwRestoreWindow(handle_->get());
             } else if (current_state != glapp::window_state::fullscreen) {
                 if (current_state == glapp::window_state::maximized) {
                     fullscreen_backup_window_rect_ = current_window_rect();
                 } else {
-                    fullscreen_backup_window_rect_ = normal_window_rect_;
+                    fullscreen_backup_window_rect_ = normal_window_rect();
                 }
                 glfwSetWindowMonitor(handle_->get(), monitor->glfw_handle(), 0, 0, monitor->rect().width(), monitor->rect().height(), monitor->refresh_rate());
-                window_state_event(*this, glapp::window_state::fullscreen);
+                // The video mode may be changed to the one closest to the requested
+                monitor->refresh();
+                post_event({ event_type::window_state, static_cast<int32_t>(glapp::window_state::fullscreen) });
             } else {
             }
+            refresh_cache();
         }
     }
 
     // Returns the monitor on which the window is currently placed
     std::shared_ptr<glapp::monitor> placed_monitor_internal() const
     {
-        int32_t i = 0;
+        std::shared_ptr<glapp::monitor> placed_monitor;
+        const auto monitors = connected_monitors();
+        if (!monitors) {
+            return placed_monitor;
+        }
         int32_t max_area = 0;
-        int32_t max_index = -1;
-        const auto monitors = all_monitors();
-        const auto wrect = (state_internal() == glapp::window_state::minimized) ? normal_window_rect_ : glapp::rect<int32_t>(pos(), size());
-        for (auto&& monitor : monitors) {
+        const auto wrect = (state_internal() == glapp::window_state::minimized) ? normal_window_rect() : glapp::rect<int32_t>(pos(), size());
+        for (auto&& monitor : *monitors) {
             const auto mrect = monitor->rect();
             const int32_t dx = (std::min)(wrect.right(), mrect.right()) - (std::max)(wrect.left(), mrect.left());
             const int32_t dy = (std::min)(wrect.bottom(), mrect.bottom()) - (std::max)(wrect.top(), mrect.top());
@@ -1378,31 +3781,123 @@ private:
                 const int32_t area = dx * dy;
                 if (max_area < area) {
                     max_area = area;
-                    max_index = i;
+                    placed_monitor = monitor;
                 }
             }
-            ++i;
         }
-        return (0 <= max_index) ? monitors[max_index] : nullptr;
+        return placed_monitor;
+    }
+
+    // Installs the GLFW callbacks needed to keep track of the window state, the input state and to redraw it
+    // Callbacks of closing and dropping are installed when the first callback is subscribed
+    void setup_callbacks()
+    {
+        install_glfw_callback(event_type::key);
+        install_glfw_callback(event_type::mouse_button);
+        install_glfw_callback(event_type::cursor_pos);
+        install_glfw_callback(event_type::cursor_enter);
+        install_glfw_callback(event_type::scroll);
+        install_glfw_callback(event_type::window_pos);
+        install_glfw_callback(event_type::window_size);
+        install_glfw_callback(event_type::window_refresh);
+        install_glfw_callback(event_type::window_focus);
+        install_glfw_callback(event_type::window_state);
+        install_glfw_callback(event_type::window_contentscale);
+        install_glfw_callback(event_type::framebuffer_size);
+    }
+
+    void install_glfw_callback(event_type type)
+    {
+        const uint32_t bit = 1u << static_cast<uint32_t>(type);
+        if (!handle_ || (installed_glfw_callbacks_ & bit) != 0) {
+            return;
+        }
+        installed_glfw_callbacks_ |= bit;
+        auto glfw_window = handle_->get();
+        switch (type) {
+        case event_type::key:
+            glfwSetKeyCallback(glfw_window, glfw_key_callback);
+            break;
+        case event_type::mouse_button:
+            glfwSetMouseButtonCallback(glfw_window, glfw_mouse_button_callback);
+            break;
+        case event_type::cursor_pos:
+            glfwSetCursorPosCallback(glfw_window, glfw_cursor_pos_callback);
+            break;
+        case event_type::cursor_enter:
+            glfwSetCursorEnterCallback(glfw_window, glfw_cursor_enter_callback);
+            break;
+        case event_type::scroll:
+            glfwSetScrollCallback(glfw_window, glfw_scroll_callback);
+            break;
+        case event_type::window_pos:
+            glfwSetWindowPosCallback(glfw_window, glfw_window_pos_callback);
+            break;
+        case event_type::window_size:
+            glfwSetWindowSizeCallback(glfw_window, glfw_window_size_callback);
+            break;
+        case event_type::window_close:
+            glfwSetWindowCloseCallback(glfw_window, glfw_window_close_callback);
+            break;
+        case event_type::window_refresh:
+            glfwSetWindowRefreshCallback(glfw_window, glfw_window_refresh_callback);
+            break;
+        case event_type::window_focus:
+            glfwSetWindowFocusCallback(glfw_window, glfw_window_focus_callback);
+            break;
+        case event_type::window_state:
+            glfwSetWindowIconifyCallback(glfw_window, glfw_window_iconify_callback);
+            glfwSetWindowMaximizeCallback(glfw_window, glfw_window_maximize_callback);
+            break;
+        case event_type::window_contentscale:
+            glfwSetWindowContentScaleCallback(glfw_window, glfw_window_contentscale_callback);
+            break;
+        case event_type::framebuffer_size:
+            glfwSetFramebufferSizeCallback(glfw_window, glfw_framebuffer_size_callback);
+            break;
+        case event_type::drop:
+            glfwSetDropCallback(glfw_window, glfw_drop_callback);
+            break;
+        }
+    }
+
+    // Updates the cached properties after changing them, since GLFW notifies the change later
+    void refresh_cache()
+    {
+        if (handle_) {
+            auto glfw_window = handle_->get();
+            int32_t x = 0;
+            int32_t y = 0;
+            glfwGetWindowPos(glfw_window, &x, &y);
+            pos_cache_.store(x, y);
+            glfwGetWindowSize(glfw_window, &x, &y);
+            size_cache_.store(x, y);
+            glfwGetFramebufferSize(glfw_window, &x, &y);
+            framebuffer_size_cache_.store(x, y);
+            float xscale = 0.0f;
+            float yscale = 0.0f;
+            glfwGetWindowContentScale(glfw_window, &xscale, &yscale);
+            contentscale_cache_.store(xscale, yscale);
+            state_cache_ = query_state();
+            focused_cache_ = glfwGetWindowAttrib(glfw_window, GLFW_FOCUSED) == GLFW_TRUE;
+        }
+    }
+
+    void store_normal_window_rect(const glapp::rect<int32_t>& rect)
+    {
+        normal_window_pos_.store(rect.x(), rect.y());
+        normal_window_size_.store(rect.width(), rect.height());
     }
 
-    static void setup_callbacks(GLFWwindow* glfw_window)
+    glapp::rect<int32_t> normal_window_rect() const
     {
-        glfwSetKeyCallback(glfw_window, glfw_key_callback);
-        glfwSetMouseButtonCallback(glfw_window, glfw_mouse_button_callback);
-        glfwSetCursorPosCallback(glfw_window, glfw_cursor_pos_callback);
-        glfwSetCursorEnterCallback(glfw_window, glfw_cursor_enter_callback);
-        glfwSetScrollCallback(glfw_window, glfw_scroll_callback);
-        glfwSetWindowPosCallback(glfw_window, glfw_window_pos_callback);
-        glfwSetWindowSizeCallback(glfw_window, glfw_window_size_callback);
-        glfwSetWindowCloseCallback(glfw_window, glfw_window_close_callback);
-        glfwSetWindowRefreshCallback(glfw_window, glfw_window_refresh_callback);
-        glfwSetWindowFocusCallback(glfw_window, glfw_window_focus_callback);
-        glfwSetWindowIconifyCallback(glfw_window, glfw_window_iconify_callback);
-        glfwSetWindowMaximizeCallback(glfw_window, glfw_window_maximize_callback);
-        glfwSetFramebufferSizeCallback(glfw_window, glfw_framebuffer_size_callback);
-        glfwSetWindowContentScaleCallback(glfw_window, glfw_window_contentscale_callback);
-        glfwSetDropCallback(glfw_window, glfw_drop_callback);
+        int32_t x = 0;
+        int32_t y = 0;
+        int32_t width = 0;
+        int32_t height = 0;
+        normal_window_pos_.load(x, y);
+        normal_window_size_.load(width, height);
+        return { x, y, width, height };
     }
 
     glapp::rect<int32_t> current_window_rect()
@@ -1420,165 +3915,1090 @@ private:
         return rect;
     }
 
-    void set_size_limit_internal()
+    void set_size_limit_internal()
+    {
+        if (handle_) {
+            int min_width = GLFW_DONT_CARE;
+            int min_height = GLFW_DONT_CARE;
+            int max_width = GLFW_DONT_CARE;
+            int max_height = GLFW_DONT_CARE;
+            if (size_limit_min_) {
+                min_width = size_limit_min_.width();
+                min_height = size_limit_min_.height();
+            }
+            if (size_limit_max_) {
+                max_width = size_limit_max_.width();
+                max_height = size_limit_max_.height();
+            }
+            glfwSetWindowSizeLimits(handle_->get(), min_width, min_height, max_width, max_height);
+            refresh_cache();
+        }
+    }
+
+    static void glfw_key_callback(GLFWwindow* glfw_window, int key, int scancode, int state, int mods)
+    {
+        (void)scancode;
+        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
+        assert(window != nullptr);
+        window->invalidated_ = true;
+        window->post_event({ event_type::key, key, state, mods });
+    }
+
+    static void glfw_mouse_button_callback(GLFWwindow* glfw_window, int button, int action, int mods)
+    {
+        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
+        assert(window != nullptr);
+        window->invalidated_ = true;
+        window->post_event({ event_type::mouse_button, button, action, mods });
+    }
+
+    static void glfw_cursor_pos_callback(GLFWwindow* glfw_window, double x, double y)
+    {
+        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
+        assert(window != nullptr);
+        window->invalidated_ = true;
+        window->post_event({ event_type::cursor_pos, x, y });
+    }
+
+    static void glfw_cursor_enter_callback(GLFWwindow* glfw_window, int entered)
+    {
+        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
+        assert(window != nullptr);
+        window->invalidated_ = true;
+        window->post_event({ event_type::cursor_enter, entered });
+    }
+
+    static void glfw_scroll_callback(GLFWwindow* glfw_window, double xoffset, double yoffset)
+    {
+        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
+        assert(window != nullptr);
+        window->invalidated_ = true;
+        window->post_event({ event_type::scroll, xoffset, yoffset });
+    }
+
+    // `glfwSetWindowMonitor` calls the position and size callbacks before the state is cached on some platforms,
+    // while the monitor of the window is already set
+    bool is_normal_in_callback() const
+    {
+        return state_internal() == glapp::window_state::normal && glfwGetWindowMonitor(handle_->get()) == nullptr;
+    }
+
+    static void glfw_window_pos_callback(GLFWwindow* glfw_window, int xpos, int ypos)
+    {
+        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
+        assert(window != nullptr);
+        window->pos_cache_.store(xpos, ypos);
+        if (window->is_normal_in_callback()) {
+            window->store_normal_window_rect(glapp::rect<int32_t>(window->pos(), window->size()));
+        }
+        window->post_event({ event_type::window_pos, xpos, ypos });
+    }
+
+    static void glfw_window_size_callback(GLFWwindow* glfw_window, int width, int height)
+    {
+        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
+        assert(window != nullptr);
+        window->size_cache_.store(width, height);
+        if (window->is_normal_in_callback()) {
+            window->store_normal_window_rect(glapp::rect<int32_t>(window->pos(), window->size()));
+        }
+        window->invalidated_ = true;
+        window->post_event({ event_type::window_size, width, height });
+    }
+
+    static void glfw_window_close_callback(GLFWwindow* glfw_window)
+    {
+        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
+        assert(window != nullptr);
+        // Dispatched on the main thread even while the window is drawn in another thread,
+        // so that the callback can cancel closing before the main loop destroys the window
+        window->dispatch_event(queued_event(event_type::window_close));
+    }
+
+    static void glfw_window_refresh_callback(GLFWwindow* glfw_window)
+    {
+        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
+        assert(window != nullptr);
+        window->invalidated_ = true;
+        window->post_event({ event_type::window_refresh });
+    }
+
+    static void glfw_window_focus_callback(GLFWwindow* glfw_window, int focused)
+    {
+        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
+        assert(window != nullptr);
+        window->focused_cache_ = (focused == GLFW_TRUE);
+        window->invalidated_ = true;
+        window->post_event({ event_type::window_focus, focused });
+    }
+
+    static void glfw_window_iconify_callback(GLFWwindow* glfw_window, int iconified)
+    {
+        (void)iconified;
+        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
+        assert(window != nullptr);
+        auto state = window->query_state();
+        window->state_cache_ = state;
+        window->invalidated_ = true;
+        window->post_event({ event_type::window_state, static_cast<int32_t>(state) });
+    }
+
+    static void glfw_window_maximize_callback(GLFWwindow* glfw_window, int maximized)
+    {
+        (void)maximized;
+        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
+        assert(window != nullptr);
+        auto state = window->query_state();
+        window->state_cache_ = state;
+        window->invalidated_ = true;
+        window->post_event({ event_type::window_state, static_cast<int32_t>(state) });
+    }
+
+    static void glfw_framebuffer_size_callback(GLFWwindow* glfw_window, int width, int height)
+    {
+        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
+        assert(window != nullptr);
+        window->framebuffer_size_cache_.store(width, height);
+        window->invalidated_ = true;
+        window->post_event({ event_type::framebuffer_size, width, height });
+    }
+
+    static void glfw_window_contentscale_callback(GLFWwindow* glfw_window, float xscale, float yscale)
+    {
+        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
+        assert(window != nullptr);
+        window->contentscale_cache_.store(xscale, yscale);
+        window->invalidated_ = true;
+        window->post_event({ event_type::window_contentscale, static_cast<double>(xscale), static_cast<double>(yscale) });
+    }
+
+    static void glfw_drop_callback(GLFWwindow* glfw_window, int path_count, const char* paths[])
+    {
+        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
+        assert(window != nullptr);
+        queued_event event(event_type::drop, path_count);
+        if (window->event_queue_) {
+            // GLFW releases the paths on returning, so copy them into a single buffer holding the pointers followed by the strings
+            size_t length = path_count * sizeof(const char*);
+            for (int32_t i = 0; i < path_count; ++i) {
+                length += std::strlen(paths[i]) + 1;
+            }
+            event.path_storage.reset(new char[length]);
+            auto pointers = reinterpret_cast<const char**>(event.path_storage.get());
+            auto text = event.path_storage.get() + path_count * sizeof(const char*);
+            for (int32_t i = 0; i < path_count; ++i) {
+                const auto size = std::strlen(paths[i]) + 1;
+                std::memcpy(text, paths[i], size);
+                pointers[i] = text;
+                text += size;
+            }
+            event.paths = pointers;
+        } else {
+            event.paths = paths;
+        }
+        window->invalidated_ = true;
+        window->post_event(std::move(event));
+    }
+
+    // Delivers the event to the callbacks, or queues it while the window is drawn in another thread
+    void post_event(queued_event&& event)
+    {
+        if (event_queue_) {
+            event_queue_->push(std::move(event));
+            wake_drawing_thread();
+        } else {
+            deliver_event(event);
+        }
+    }
+
+    // Delivers the queued events and the coalesced events on the drawing thread
+    void process_queued_events()
+    {
+        if (event_queue_) {
+            queued_event event;
+            while (event_queue_->pop(event)) {
+                deliver_event(event);
+            }
+        }
+        flush_coalesced_events();
+    }
+
+    static int32_t coalescible_index(event_type type)
+    {
+        // clang-format off
+        return
+            (type == event_type::cursor_pos) ? static_cast<int32_t>(glapp::coalescible_event::mouse_pos) :
+            (type == event_type::scroll) ? static_cast<int32_t>(glapp::coalescible_event::mouse_wheel) :
+            (type == event_type::window_pos) ? static_cast<int32_t>(glapp::coalescible_event::window_pos) :
+            (type == event_type::window_size) ? static_cast<int32_t>(glapp::coalescible_event::window_size) :
+            (type == event_type::window_contentscale) ? static_cast<int32_t>(glapp::coalescible_event::window_contentscale) :
+            (type == event_type::framebuffer_size) ? static_cast<int32_t>(glapp::coalescible_event::framebuffer_size) :
+            -1;
+        // clang-format on
+    }
+
+    void deliver_event(queued_event& event)
+    {
+        track_input(event);
+        const int32_t index = coalescible_index(event.type);
+        const auto policy = (0 <= index) ? coalescing_[index].load() : glapp::coalescing::none;
+        if (policy == glapp::coalescing::none) {
+            if (index < 0) {
+                // Keep the order of the coalesced events and the others, such as moving and clicking
+                flush_coalesced_events();
+            }
+            dispatch_event(event);
+        } else if (policy == glapp::coalescing::accumulate && event.type == event_type::scroll && coalesced_event_pending_[index]) {
+            coalesced_events_[index].values[0] += event.values[0];
+            coalesced_events_[index].values[1] += event.values[1];
+        } else {
+            coalesced_events_[index] = std::move(event);
+            coalesced_event_pending_[index] = true;
+        }
+    }
+
+    void track_input(const queued_event& event)
+    {
+        switch (event.type) {
+        case event_type::key:
+            if (0 <= event.args[0] && event.args[0] <= GLFW_KEY_LAST) {
+                live_input_.keys_[event.args[0]] = (event.args[1] != GLFW_RELEASE);
+            }
+            live_input_.mods_ = event.args[2];
+            break;
+        case event_type::mouse_button:
+            if (0 <= event.args[0] && event.args[0] <= GLFW_MOUSE_BUTTON_LAST) {
+                live_input_.buttons_[event.args[0]] = (event.args[1] != GLFW_RELEASE);
+            }
+            live_input_.mods_ = event.args[2];
+            break;
+        case event_type::cursor_pos:
+            live_input_.cursor_x_ = event.values[0];
+            live_input_.cursor_y_ = event.values[1];
+            break;
+        case event_type::cursor_enter:
+            live_input_.cursor_entered_ = (event.args[0] == GLFW_TRUE);
+            break;
+        case event_type::scroll:
+            live_input_.scroll_x_ += event.values[0];
+            live_input_.scroll_y_ += event.values[1];
+            break;
+        default:
+            break;
+        }
+    }
+
+    void flush_coalesced_events()
+    {
+        for (size_t i = 0; i < coalescible_event_count; ++i) {
+            if (coalesced_event_pending_[i]) {
+                coalesced_event_pending_[i] = false;
+                dispatch_event(coalesced_events_[i]);
+            }
+        }
+    }
+
+    static uint32_t next_trace_id()
+    {
+        static std::atomic<uint32_t> trace_id { 0 };
+        return ++trace_id;
+    }
+
+    // Unique among all windows, so that the subscription to another window is never removed by mistake
+    static uint64_t next_subscription_id()
+    {
+        static std::atomic<uint64_t> subscription_id { 0 };
+        return ++subscription_id;
+    }
+
+    static const char* event_name(event_type type)
+    {
+        static const char* const names[] = {
+            "key_event",
+            "mouse_button_event",
+            "cursor_pos_event",
+            "cursor_enter_event",
+            "scroll_event",
+            "window_pos_event",
+            "window_size_event",
+            "window_close_event",
+            "window_refresh_event",
+            "window_focus_event",
+            "window_state_event",
+            "window_contentscale_event",
+            "framebuffer_size_event",
+            "drop_event"
+        };
+        return names[static_cast<size_t>(type)];
+    }
+
+    void dispatch_event(const queued_event& event)
+    {
+        GLAPP_INTERNAL_ZONE(event_name(event.type), trace_id_);
+        switch (event.type) {
+        case event_type::key:
+            key_event(*this, static_cast<glapp::key>(event.args[0]), glapp::key_state(event.args[1]), glapp::modifier(event.args[2]));
+            break;
+        case event_type::mouse_button:
+            mouse_button_event(*this, static_cast<glapp::mouse_button>(event.args[0]), glapp::button_state(event.args[1]), glapp::modifier(event.args[2]));
+            break;
+        case event_type::cursor_pos:
+            cursor_pos_event(*this, event.values[0], event.values[1]);
+            break;
+        case event_type::cursor_enter:
+            cursor_enter_event(*this, event.args[0] == GLFW_TRUE);
+            break;
+        case event_type::scroll:
+            scroll_event(*this, event.values[0], event.values[1]);
+            break;
+        case event_type::window_pos:
+            window_pos_event(*this, event.args[0], event.args[1]);
+            break;
+        case event_type::window_size:
+            window_size_event(*this, event.args[0], event.args[1]);
+            break;
+        case event_type::window_close:
+            window_close_event(*this);
+            break;
+        case event_type::window_refresh:
+            window_refresh_event(*this);
+            break;
+        case event_type::window_focus:
+            window_focus_event(*this, event.args[0] == GLFW_TRUE);
+            break;
+        case event_type::window_state:
+            window_state_event(*this, static_cast<glapp::window_state>(event.args[0]));
+            break;
+        case event_type::window_contentscale:
+            window_contentscale_event(*this, static_cast<float>(event.values[0]), static_cast<float>(event.values[1]));
+            break;
+        case event_type::framebuffer_size:
+            framebuffer_size_event(*this, event.args[0], event.args[1]);
+            break;
+        case event_type::drop:
+            drop_event(*this, glapp::path_span(event.paths, static_cast<size_t>(event.args[0])));
+            break;
+        }
+    }
+
+    // swap_interval - the interval actually applied, which may differ from `swap_interval_` by presentation scheduling
+    void draw(int32_t swap_interval)
+    {
+        if (handle_) {
+            GLAPP_INTERNAL_ZONE("draw", trace_id_);
+            glfwMakeContextCurrent(handle_->get());
+            render(swap_interval);
+            // Avoid crash when multi window
+            glfwMakeContextCurrent(NULL);
+        }
+    }
+
+    // The context of this window must be current on the calling thread
+    void render(int32_t swap_interval)
+    {
+        process_queued_events();
+        input_ = live_input_;
+        live_input_.scroll_x_ = 0.0;
+        live_input_.scroll_y_ = 0.0;
+        const auto now = internal::clock::now();
+        if (paused_.exchange(false)) {
+            // Start measuring the intervals over after resuming
+            last_frame_time_ = {};
+        }
+        schedule_next_frame(now);
+        // Invalidation while drawing the frame requests the next frame
+        invalidated_ = false;
+        const double alpha = update(now);
+#if !defined(GLAPP_DISABLE_PROFILING)
+        // Only for the trace, which covers the preparation of the frame as well
+        const auto frame_begin_time = internal::clock::now();
+#endif
+        begin_offscreen_target();
+        begin_gpu_timing();
+        if (frame_capturer_) {
+            frame_capturer_->collect();
+        }
+        const auto callback_begin_time = internal::clock::now();
+        frame_event(*this, alpha);
+        const auto callback_end_time = internal::clock::now();
+        if (gpu_timer_) {
+            gpu_timer_->end_frame();
+        }
+        end_capture();
+        const auto swap_begin_time = internal::clock::now();
+        if (headless_) {
+            offscreen_target_->flush();
+        } else {
+            if (last_swap_interval_ != swap_interval) {
+                glfwSwapInterval(swap_interval);
+                last_swap_interval_ = swap_interval;
+            }
+            glfwSwapBuffers(handle_->get());
+        }
+        const auto swap_end_time = internal::clock::now();
+        record_frame(now, callback_end_time - callback_begin_time, swap_end_time - swap_begin_time);
+#if !defined(GLAPP_DISABLE_PROFILING)
+        auto& tracer = internal::tracer::instance();
+        if (tracer.enabled()) {
+            tracer.record("frame", frame_begin_time, swap_begin_time, trace_id_);
+            tracer.record("swap", swap_begin_time, swap_end_time, trace_id_);
+        }
+#endif
+        ++frame_count_;
+    }
+
+    // Binds the framebuffer object of the headless window, which follows the framebuffer size of the window
+    void begin_offscreen_target()
+    {
+        if (headless_ && !offscreen_target_) {
+            offscreen_target_.reset(new offscreen_target());
+            // The headless window draws into its hidden default framebuffer if the framebuffer object is not supported,
+            // which is told by `framebuffer_id` returning 0
+            offscreen_target_->load(context_version_major_);
+        }
+        if (offscreen_target_) {
+            int32_t width = 0;
+            int32_t height = 0;
+            framebuffer_size_cache_.load(width, height);
+            offscreen_target_->bind({ width, height });
+        }
+    }
+
+    void end_capture()
+    {
+        if (!capture_callbacks_.empty()) {
+            int32_t width = 0;
+            int32_t height = 0;
+            framebuffer_size_cache_.load(width, height);
+            frame_capturer_->capture(frame_count_, framebuffer_id(), width, height, capture_callbacks_);
+        }
+        if (frame_capturer_ && frame_capturer_->pending()) {
+            // Draw the next frame to collect the pixels even in `render_mode::on_demand`
+            invalidated_ = true;
+        }
+    }
+
+    void begin_gpu_timing()
+    {
+        if (gpu_timing_enabled_ && !gpu_timer_) {
+            gpu_timer_.reset(new gpu_timer());
+            if (!gpu_timer_->load()) {
+                gpu_timer_.reset();
+                gpu_timing_enabled_ = false;
+            }
+        } else if (!gpu_timing_enabled_ && gpu_timer_) {
+            gpu_timer_->release();
+            gpu_timer_.reset();
+            gpu_timing_ = {};
+        }
+        if (gpu_timer_) {
+            gpu_timer_->begin_frame(frame_count_, gpu_timing_);
+        }
+    }
+
+    void record_frame(internal::clock::time_point frame_time, internal::clock::duration cpu_time, internal::clock::duration swap_time)
+    {
+        using seconds = std::chrono::duration<float>;
+        const float interval = (last_frame_time_ != internal::clock::time_point {}) ? seconds(frame_time - last_frame_time_).count() : -1.0f;
+        last_frame_time_ = frame_time;
+        // Idle time between frames drawn on demand is not regarded as dropping
+        const bool continuous = (render_mode_ == glapp::render_mode::continuous);
+        const double expected_interval = (0.0 < scheduled_fps_) ? 1.0 / scheduled_fps_ : average_interval_;
+        std::lock_guard<std::mutex> lock(frame_stats_mtx_);
+        frame_samples_[frame_sample_count_ % frame_sample_capacity] = { seconds(cpu_time).count(), seconds(swap_time).count(), interval };
+        ++frame_sample_count_;
+        if (continuous && 0.0f <= interval) {
+            if (0.0 < expected_interval && expected_interval * 1.5 < interval) {
+                ++dropped_frame_count_;
+            } else {
+                average_interval_ = (0.0 < average_interval_) ? average_interval_ * 0.9 + interval * 0.1 : interval;
+            }
+        }
+    }
+
+    // Returns the time at which the next frame should be drawn
+    // Returns `time_point::max()` if no frame is requested
+    internal::clock::time_point next_frame_time() const
+    {
+        if (paused()) {
+            paused_ = true;
+            return internal::clock::time_point::max();
+        }
+        if (render_mode_ == glapp::render_mode::on_demand && !invalidated_) {
+            return internal::clock::time_point::max();
+        }
+        // A change of the frame rate takes effect immediately
+        return (throttled_fps() == scheduled_fps_) ? next_frame_time_ : internal::clock::time_point {};
+    }
+
+    // Returns the target frame rate limited by the throttle policy
+    double throttled_fps() const
+    {
+        const double target_fps = target_fps_;
+        const double unfocused_fps = unfocused_fps_;
+        if (headless_ || focused_cache_ || unfocused_fps <= 0.0) {
+            return target_fps;
+        }
+        return (0.0 < target_fps) ? (std::min)(target_fps, unfocused_fps) : unfocused_fps;
+    }
+
+    void schedule_next_frame(internal::clock::time_point now)
+    {
+        scheduled_fps_ = throttled_fps();
+        if (0.0 < scheduled_fps_) {
+            const auto period = std::chrono::duration_cast<internal::clock::duration>(std::chrono::duration<double>(1.0 / scheduled_fps_));
+            // Advance from the previous schedule to avoid drift,
+            // and resynchronize instead of bursting frames when falling behind
+            next_frame_time_ += period;
+            if (next_frame_time_ < now) {
+                next_frame_time_ = now + period;
+            }
+        } else {
+            next_frame_time_ = {};
+        }
+    }
+
+    // Runs the fixed time step updates for the time elapsed since the last frame
+    // Returns the interpolation factor between the last update and the next update
+    double update(internal::clock::time_point now)
+    {
+        const double rate = update_rate_;
+        if (!update_event || rate <= 0.0) {
+            last_update_time_ = {};
+            return 0.0;
+        }
+        if (last_update_time_ != internal::clock::time_point {}) {
+            update_accumulator_ += std::chrono::duration<double>(now - last_update_time_).count();
+        }
+        last_update_time_ = now;
+        GLAPP_INTERNAL_ZONE("update", trace_id_);
+        const double dt = 1.0 / rate;
+        const int32_t max_updates = max_updates_per_frame_;
+        int32_t count = 0;
+        while (dt <= update_accumulator_ && count < max_updates) {
+            update_event(*this, dt);
+            update_accumulator_ -= dt;
+            ++count;
+        }
+        // Drop the time which could not be caught up
+        update_accumulator_ = (std::min)(update_accumulator_, dt);
+        return (std::min)(update_accumulator_ / dt, 1.0 - std::numeric_limits<double>::epsilon());
+    }
+
+    void wake_drawing_thread() const
+    {
+        if (auto signal = std::atomic_load(&drawing_signal_)) {
+            signal->notify();
+        }
+    }
+
+    void start_render_thread()
+    {
+        if (handle_ && !render_thread_.joinable()) {
+            std::atomic_store(&drawing_signal_, std::make_shared<internal::wake_signal>());
+            rendering_ = true;
+            render_thread_ = std::thread(&window::render_loop, this);
+        }
+    }
+
+    void stop_render_thread()
     {
-        if (handle_) {
-            int min_width = GLFW_DONT_CARE;
-            int min_height = GLFW_DONT_CARE;
-            int max_width = GLFW_DONT_CARE;
-            int max_height = GLFW_DONT_CARE;
-            if (size_limit_min_) {
-                min_width = size_limit_min_.width();
-                min_height = size_limit_min_.height();
-            }
-            if (size_limit_max_) {
-                max_width = size_limit_max_.width();
-                max_height = size_limit_max_.height();
-            }
-            glfwSetWindowSizeLimits(handle_->get(), min_width, min_height, max_width, max_height);
+        rendering_ = false;
+        wake_drawing_thread();
+        if (render_thread_.joinable()) {
+            render_thread_.join();
         }
     }
 
-    static void glfw_key_callback(GLFWwindow* glfw_window, int key, int scancode, int state, int mods)
+    // Keeps the context current on the render thread for the whole lifetime of the thread
+    void render_loop()
     {
-        (void)scancode;
-        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
-        assert(window != nullptr);
-        std::string key_name = internal::key_to_name(key);
-        window->key_event(*window, key_name, glapp::key_state(state), glapp::modifier(mods));
+        internal::tracer::instance().set_thread_name("render");
+        glfwMakeContextCurrent(handle_->get());
+        const auto signal = std::atomic_load(&drawing_signal_);
+        // Stopped by the main loop after closing, since the close callback may cancel it
+        while (rendering_) {
+            const auto next_frame_time = this->next_frame_time();
+            if (internal::clock::now() < next_frame_time) {
+                // Sleep until the frame is due, or until woken up by invalidation, events or closing
+                signal->wait_until(next_frame_time);
+            } else {
+                // Each render thread blocks on its own swap, so no presentation scheduling is needed
+                render(swap_interval_);
+                // Let the thread processing events run between the frames drawn back to back
+                std::this_thread::yield();
+            }
+        }
+        glfwMakeContextCurrent(NULL);
+        // Wake up the event loop to destroy the closed window
+        glfwPostEmptyEvent();
     }
 
-    static void glfw_mouse_button_callback(GLFWwindow* glfw_window, int button, int action, int mods)
+    static std::shared_ptr<const std::vector<std::shared_ptr<glapp::monitor>>> connected_monitors();
+    static void refresh_monitor(GLFWmonitor* glfw_monitor);
+};
+
+// Measures the GPU time in the scope, see 'window::begin_gpu_zone'
+class gpu_zone : internal::noncopyable {
+private:
+    glapp::window& window_;
+
+public:
+    gpu_zone(glapp::window& window, const char* name)
+        : window_(window)
     {
-        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
-        assert(window != nullptr);
-        std::string button_name = internal::mouse_button_to_name(button);
-        window->mouse_button_event(*window, button_name, glapp::button_state(action), glapp::modifier(mods));
+        window_.begin_gpu_zone(name);
     }
 
-    static void glfw_cursor_pos_callback(GLFWwindow* glfw_window, double x, double y)
+    ~gpu_zone()
     {
-        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
-        assert(window != nullptr);
-        window->cursor_pos_event(*window, x, y);
+        window_.end_gpu_zone();
     }
+};
 
-    static void glfw_cursor_enter_callback(GLFWwindow* glfw_window, int entered)
-    {
-        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
-        assert(window != nullptr);
-        window->cursor_enter_event(*window, entered);
+// Records the frames of the window into a YUV4MPEG2 (Y4M) file of I420 frames
+// The frames are read back by 'window::capture_async', converted on the worker threads and written on the writer thread,
+// so that the render thread is never blocked. Frames are dropped while the writer cannot keep up
+// ATTENTION: The recorder must be created before 'app::run' or inside the callbacks of the window, as 'window::on_frame'
+class recorder : internal::noncopyable {
+private:
+    // Number of the frames converted or being written, which limits the memory and applies the backpressure
+    static constexpr size_t max_pending_frames = 4;
+
+    struct encoded_frame {
+        std::vector<uint8_t> planes;
+    };
+
+    // Shared with the callbacks, which may outlive the recorder
+    struct state {
+        explicit state(size_t worker_count)
+            : pool(worker_count, "encoder")
+        {
+        }
+
+        std::atomic<bool> recording { true };
+        std::atomic<int64_t> recorded_count { 0 };
+        std::atomic<int64_t> dropped_count { 0 };
+        internal::worker_pool pool;
+        int32_t fps = 0;
+        std::ofstream file;
+        // Following members are locked by `mtx`
+        std::mutex mtx;
+        std::condition_variable cv;
+        glapp::subscription subscription;
+        // Size of the frames, which is fixed by the first frame
+        int32_t width = 0;
+        int32_t height = 0;
+        std::vector<std::vector<uint8_t>> free_planes;
+        std::vector<encoded_frame> queue;
+        bool converting = false;
+    };
+
+    std::shared_ptr<state> state_;
+    std::thread writer_;
+    bool opened_ = false;
+
+public:
+    // path - Y4M file to be overwritten
+    // fps - frame rate written in the file, which does not affect capturing
+    // worker_count - number of the threads converting the frames in addition to the capturing thread
+    recorder(glapp::window& window, const char* path, int32_t fps = 60, size_t worker_count = 2)
+        : state_(std::make_shared<state>(worker_count))
+    {
+        state_->fps = fps;
+        state_->file.open(internal::or_empty(path), std::ios::binary);
+        if (!state_->file) {
+            state_->recording = false;
+            return;
+        }
+        opened_ = true;
+        // The callback removes itself after recording is stopped
+        auto subscription = window.on_frame([s = state_](glapp::window& window) {
+            if (!s->recording) {
+                std::lock_guard<std::mutex> lock(s->mtx);
+                window.unsubscribe(s->subscription);
+                return;
+            }
+            if (!window.capture_async([s](const glapp::captured_frame& frame) { encode(*s, frame); })) {
+                // Not supported by the context, which is told by `recording`
+                stop_recording(*s);
+            }
+        });
+        {
+            std::lock_guard<std::mutex> lock(state_->mtx);
+            state_->subscription = subscription;
+        }
+        writer_ = std::thread(&recorder::write, state_);
     }
 
-    static void glfw_scroll_callback(GLFWwindow* glfw_window, double xoffset, double yoffset)
+    // Stops recording and waits for the captured frames to be written
+    ~recorder()
     {
-        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
-        assert(window != nullptr);
-        window->scroll_event(*window, xoffset, yoffset);
+        stop();
     }
 
-    static void glfw_window_pos_callback(GLFWwindow* glfw_window, int xpos, int ypos)
+    // Returns false if the file could not be opened
+    operator bool() const { return opened_; }
+
+    bool recording() const { return state_->recording; }
+
+    // Returns the number of the frames written to the file
+    int64_t recorded_frames() const { return state_->recorded_count; }
+
+    // Returns the number of the frames dropped by the recorder, in addition to 'window::dropped_capture_count'
+    int64_t dropped_frames() const { return state_->dropped_count; }
+
+    // Stops recording and waits for the captured frames to be written
+    // The frames still being read back from the GPU are discarded
+    void stop()
     {
-        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
-        assert(window != nullptr);
-        if (window->state_internal() == glapp::window_state::normal) {
-            window->normal_window_rect_ = window->current_window_rect();
+        stop_recording(*state_);
+        if (writer_.joinable()) {
+            writer_.join();
         }
-        window->window_pos_event(*window, xpos, ypos);
+        state_->file.close();
     }
 
-    static void glfw_window_size_callback(GLFWwindow* glfw_window, int width, int height)
+private:
+    // The flag is changed under the lock, so that the change is never missed by the threads about to wait for it
+    static void stop_recording(state& s)
     {
-        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
-        assert(window != nullptr);
-        if (window->state_internal() == glapp::window_state::normal) {
-            window->normal_window_rect_ = window->current_window_rect();
-            // window->normal_window_size_ = glapp::size<int32_t>(width, height);
+        {
+            std::lock_guard<std::mutex> lock(s.mtx);
+            s.recording = false;
         }
-        window->window_size_event(*window, width, height);
+        s.cv.notify_all();
     }
 
-    static void glfw_window_close_callback(GLFWwindow* glfw_window)
+    // Called on the capturing thread of the window
+    static void encode(state& s, const glapp::captured_frame& frame)
     {
-        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
-        assert(window != nullptr);
-        window->window_close_event(*window);
+        const int32_t width = frame.width();
+        const int32_t height = frame.height();
+        const int32_t chroma_height = (height + 1) / 2;
+        const size_t luma_size = static_cast<size_t>(width) * height;
+        const size_t chroma_size = static_cast<size_t>((width + 1) / 2) * chroma_height;
+        std::vector<uint8_t> planes;
+        {
+            std::unique_lock<std::mutex> lock(s.mtx);
+            if (!s.recording) {
+                ++s.dropped_count;
+                return;
+            } else if (s.width == 0) {
+                s.width = width;
+                s.height = height;
+                s.file << "YUV4MPEG2 W" << width << " H" << height << " F" << s.fps << ":1 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n";
+            } else if (s.width != width || s.height != height) {
+                // The size of the frames cannot be changed in the file
+                ++s.dropped_count;
+                return;
+            }
+            // Wait for the writer rather than queueing frames without limit,
+            // then the frames are dropped by 'window::capture_async' without blocking the render thread
+            s.cv.wait(lock, [&s] { return !s.recording || s.queue.size() + (s.converting ? 1 : 0) < max_pending_frames; });
+            if (!s.recording) {
+                ++s.dropped_count;
+                return;
+            }
+            s.converting = true;
+            if (!s.free_planes.empty()) {
+                planes = std::move(s.free_planes.back());
+                s.free_planes.pop_back();
+            }
+        }
+        planes.resize(luma_size + chroma_size * 2);
+        uint8_t* y_plane = planes.data();
+        uint8_t* u_plane = y_plane + luma_size;
+        uint8_t* v_plane = u_plane + chroma_size;
+        const size_t chunk_count = (std::min)(s.pool.concurrency() * 2, static_cast<size_t>(chroma_height));
+        s.pool.run(chunk_count, [&](size_t index) {
+            const auto begin = static_cast<int32_t>(chroma_height * index / chunk_count);
+            const auto end = static_cast<int32_t>(chroma_height * (index + 1) / chunk_count);
+            internal::rgba_to_i420(frame.pixels(), width, height, begin, end, y_plane, u_plane, v_plane);
+        });
+        {
+            std::lock_guard<std::mutex> lock(s.mtx);
+            s.converting = false;
+            s.queue.push_back({ std::move(planes) });
+        }
+        s.cv.notify_all();
     }
 
-    static void glfw_window_refresh_callback(GLFWwindow* glfw_window)
+    // Runs on the writer thread until recording is stopped and the queued frames are written
+    static void write(std::shared_ptr<state> s)
     {
-        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
-        assert(window != nullptr);
-        window->window_refresh_event(*window);
+        internal::tracer::instance().set_thread_name("writer");
+        std::vector<encoded_frame> frames;
+        std::unique_lock<std::mutex> lock(s->mtx);
+        while (true) {
+            s->cv.wait(lock, [&s] { return !s->queue.empty() || (!s->recording && !s->converting); });
+            if (s->queue.empty()) {
+                break;
+            }
+            frames.swap(s->queue);
+            lock.unlock();
+            for (auto&& frame : frames) {
+                s->file << "FRAME\n";
+                s->file.write(reinterpret_cast<const char*>(frame.planes.data()), static_cast<std::streamsize>(frame.planes.size()));
+                ++s->recorded_count;
+            }
+            lock.lock();
+            for (auto&& frame : frames) {
+                s->free_planes.push_back(std::move(frame.planes));
+            }
+            frames.clear();
+            // Wake up the capturing thread waiting for the queue
+            s->cv.notify_all();
+        }
     }
+};
 
-    static void glfw_window_focus_callback(GLFWwindow* glfw_window, int focused)
-    {
-        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
-        assert(window != nullptr);
-        window->window_focus_event(*window, focused == GLFW_TRUE);
+// Exports the frames of the window to the POSIX shared memory, which is read by 'frame_export_reader' in other processes
+// The frames are read back by 'window::capture_async' and copied to a ring of slots on the capturing thread,
+// and the consumers read them in place, see 'internal::frame_export_header' for the layout
+// Not supported on the platforms without POSIX shared memory
+// ATTENTION: The exporter must be created before 'app::run' or inside the callbacks of the window, as 'window::on_frame'
+class frame_exporter : internal::noncopyable {
+private:
+    // Shared with the callbacks, which may outlive the exporter
+    struct state {
+        std::atomic<bool> exporting { true };
+        std::atomic<int64_t> exported_count { 0 };
+        std::atomic<int64_t> dropped_count { 0 };
+        void* memory = nullptr;
+        size_t memory_size = 0;
+        uint64_t sequence = 0;
+        std::mutex mtx;
+        glapp::subscription subscription;
+
+        ~state()
+        {
+#if defined(GLAPP_SHARED_MEMORY)
+            if (memory != nullptr) {
+                munmap(memory, memory_size);
+            }
+#endif
+        }
+    };
+
+    std::shared_ptr<state> state_ = std::make_shared<state>();
+    std::string name_;
+
+public:
+    // name - name of the shared memory, such as "/myapp_frames", which is removed on destruction
+    //        Fails if the name already exists, which is left by the process terminated abnormally until removed by `shm_unlink`
+    // slot_count - number of the frames kept in the ring
+    // capacity - maximum size of the frames, the framebuffer size of the window if not specified
+    //            Larger frames are dropped
+    frame_exporter(glapp::window& window, const char* name, uint32_t slot_count = 3, glapp::size<int32_t> capacity = {})
+        : name_(internal::or_empty(name))
+    {
+        if (!capacity) {
+            capacity = window.framebuffer_size();
+        }
+        if (!create(slot_count, static_cast<uint64_t>(capacity.width()) * static_cast<uint64_t>(capacity.height()) * 4)) {
+            state_->exporting = false;
+            return;
+        }
+        // The callback removes itself after exporting is stopped
+        auto subscription = window.on_frame([s = state_](glapp::window& window) {
+            if (!s->exporting) {
+                std::lock_guard<std::mutex> lock(s->mtx);
+                window.unsubscribe(s->subscription);
+                return;
+            }
+            if (!window.capture_async([s](const glapp::captured_frame& frame) { write(*s, frame); })) {
+                // Not supported by the context, which is told by `exporting`
+                s->exporting = false;
+            }
+        });
+        std::lock_guard<std::mutex> lock(state_->mtx);
+        state_->subscription = subscription;
     }
 
-    static void glfw_window_iconify_callback(GLFWwindow* glfw_window, int iconified)
+    ~frame_exporter()
     {
-        (void)iconified;
-        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
-        assert(window != nullptr);
-        auto state = window->state_internal();
-        window->window_state_event(*window, state);
+        state_->exporting = false;
+#if defined(GLAPP_SHARED_MEMORY)
+        if (state_->memory != nullptr) {
+            // The memory stays mapped until the frames in flight are discarded
+            shm_unlink(name_.c_str());
+        }
+#endif
     }
 
-    static void glfw_window_maximize_callback(GLFWwindow* glfw_window, int maximized)
+    // Returns false if the shared memory could not be created
+    operator bool() const { return state_->memory != nullptr; }
+
+    bool exporting() const { return state_->exporting; }
+
+    // Returns the number of the frames written to the shared memory
+    int64_t exported_frames() const { return state_->exported_count; }
+
+    // Returns the number of the frames dropped as they are larger than the capacity
+    int64_t dropped_frames() const { return state_->dropped_count; }
+
+private:
+    bool create(uint32_t slot_count, uint64_t capacity)
     {
-        (void)maximized;
-        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
-        assert(window != nullptr);
-        auto state = window->state_internal();
-        window->window_state_event(*window, state);
+#if defined(GLAPP_SHARED_MEMORY)
+        if (slot_count == 0 || capacity == 0) {
+            return false;
+        }
+        const uint64_t slot_size = (sizeof(internal::frame_export_slot) + capacity + 63) / 64 * 64;
+        const size_t size = static_cast<size_t>(sizeof(internal::frame_export_header) + slot_size * slot_count);
+        // Never truncate the existing memory, which may be mapped by another exporter and its readers
+        const int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) {
+            return false;
+        }
+        void* memory = (ftruncate(fd, static_cast<off_t>(size)) == 0) ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        close(fd);
+        if (memory == MAP_FAILED) {
+            shm_unlink(name_.c_str());
+            return false;
+        }
+        auto header = new (memory) internal::frame_export_header {};
+        std::memcpy(header->magic, "GLAPPFX", 8);
+        header->version = internal::frame_export_version;
+        header->slot_count = slot_count;
+        header->slot_size = slot_size;
+        header->capacity = capacity;
+        for (uint32_t i = 0; i < slot_count; ++i) {
+            new (static_cast<uint8_t*>(memory) + sizeof(internal::frame_export_header) + slot_size * i) internal::frame_export_slot {};
+        }
+        state_->memory = memory;
+        state_->memory_size = size;
+        return true;
+#else
+        (void)slot_count;
+        (void)capacity;
+        return false;
+#endif
     }
 
-    static void glfw_framebuffer_size_callback(GLFWwindow* glfw_window, int width, int height)
+    // Called on the capturing thread of the window
+    static void write(state& s, const glapp::captured_frame& frame)
     {
-        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
-        assert(window != nullptr);
-        window->framebuffer_size_event(*window, width, height);
+        auto header = static_cast<internal::frame_export_header*>(s.memory);
+        if (!s.exporting) {
+            return;
+        }
+        if (header->capacity < frame.size_in_bytes()) {
+            ++s.dropped_count;
+            return;
+        }
+        const uint64_t sequence = ++s.sequence;
+        auto slot = reinterpret_cast<internal::frame_export_slot*>(
+            static_cast<uint8_t*>(s.memory) + sizeof(internal::frame_export_header) + header->slot_size * (sequence % header->slot_count));
+        slot->sequence.store(sequence * 2 - 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot->frame_count = frame.frame_count();
+        slot->width = frame.width();
+        slot->height = frame.height();
+        std::memcpy(reinterpret_cast<uint8_t*>(slot) + sizeof(internal::frame_export_slot), frame.pixels(), frame.size_in_bytes());
+        slot->sequence.store(sequence * 2, std::memory_order_release);
+        header->latest.store(sequence, std::memory_order_release);
+        ++s.exported_count;
     }
+};
 
-    static void glfw_window_contentscale_callback(GLFWwindow* glfw_window, float xscale, float yscale)
+// Reads the frames exported by 'frame_exporter' in another process
+class frame_export_reader : internal::noncopyable {
+private:
+    const internal::frame_export_header* header_ = nullptr;
+    size_t size_ = 0;
+    uint64_t last_sequence_ = 0;
+    // Copied from the header validated on opening, so that the layout is not changed by another process afterwards
+    uint32_t slot_count_ = 0;
+    uint64_t slot_size_ = 0;
+    uint64_t capacity_ = 0;
+
+public:
+    // name - name of the shared memory specified to 'frame_exporter'
+    explicit frame_export_reader(const char* name)
     {
-        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
-        assert(window != nullptr);
-        window->window_contentscale_event(*window, xscale, yscale);
+#if defined(GLAPP_SHARED_MEMORY)
+        const int fd = shm_open(internal::or_empty(name), O_RDONLY, 0);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st {};
+        void* memory = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && sizeof(internal::frame_export_header) <= static_cast<size_t>(st.st_size)) {
+            size_ = static_cast<size_t>(st.st_size);
+            memory = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (memory == MAP_FAILED) {
+            return;
+        }
+        auto header = static_cast<const internal::frame_export_header*>(memory);
+        const size_t slots_size = size_ - sizeof(internal::frame_export_header);
+        if (std::memcmp(header->magic, "GLAPPFX", 8) != 0 || header->version != internal::frame_export_version
+            // The slots must be aligned and fill the whole memory, without overflowing by the corrupt values
+            || header->slot_count == 0 || header->slot_size % alignof(internal::frame_export_slot) != 0
+            || header->slot_size < sizeof(internal::frame_export_slot) || header->slot_size - sizeof(internal::frame_export_slot) < header->capacity
+            || slots_size % header->slot_count != 0 || slots_size / header->slot_count != header->slot_size) {
+            munmap(memory, size_);
+            return;
+        }
+        header_ = header;
+        slot_count_ = header->slot_count;
+        slot_size_ = header->slot_size;
+        capacity_ = header->capacity;
+#else
+        (void)name;
+#endif
     }
 
-    static void glfw_drop_callback(GLFWwindow* glfw_window, int path_count, const char* paths[])
+    ~frame_export_reader()
     {
-        auto window = static_cast<glapp::window*>(glfwGetWindowUserPointer(glfw_window));
-        assert(window != nullptr);
-        std::vector<std::string> drop_paths(path_count);
-        for (int32_t i = 0; i < path_count; ++i) {
-            drop_paths[i] = paths[i];
+#if defined(GLAPP_SHARED_MEMORY)
+        if (header_ != nullptr) {
+            munmap(const_cast<internal::frame_export_header*>(header_), size_);
         }
-        window->drop_event(*window, drop_paths);
+#endif
     }
 
-    void draw()
+    // Returns false if the shared memory could not be opened or its layout is not compatible
+    operator bool() const { return header_ != nullptr; }
+
+    // Calls the function with the latest frame, only if it is newer than the frame read last time
+    // The function receives (const glapp::captured_frame& frame), whose pixels are in the shared memory without copying
+    // Returns false if there is no new frame, or if the frame was overwritten by the producer during the call,
+    // in which case anything derived from the pixels must be discarded
+    template <typename F>
+    bool read_latest(F&& f)
     {
-        if (handle_) {
-            glfwMakeContextCurrent(handle_->get());
-            frame_event(*this);
-            if (last_swap_interval_ != swap_interval_) {
-                glfwSwapInterval(swap_interval_);
-                last_swap_interval_ = swap_interval_;
-            }
-            glfwSwapBuffers(handle_->get());
-            // Avoid crash when multi window
-            glfwMakeContextCurrent(NULL);
-            ++frame_count_;
+        if (header_ == nullptr) {
+            return false;
+        }
+        const uint64_t sequence = header_->latest.load(std::memory_order_acquire);
+        if (sequence == 0 || sequence == last_sequence_) {
+            return false;
+        }
+        auto slot = reinterpret_cast<const internal::frame_export_slot*>(
+            reinterpret_cast<const uint8_t*>(header_) + sizeof(internal::frame_export_header) + slot_size_ * (sequence % slot_count_));
+        if (slot->sequence.load(std::memory_order_acquire) != sequence * 2) {
+            return false;
+        }
+        glapp::captured_frame frame;
+        frame.frame_count_ = slot->frame_count;
+        frame.width_ = slot->width;
+        frame.height_ = slot->height;
+        frame.pixels_ = reinterpret_cast<const uint8_t*>(slot) + sizeof(internal::frame_export_slot);
+        if (capacity_ < frame.size_in_bytes()) {
+            return false;
         }
+        f(static_cast<const glapp::captured_frame&>(frame));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot->sequence.load(std::memory_order_relaxed) != sequence * 2) {
+            return false;
+        }
+        last_sequence_ = sequence;
+        return true;
     }
-
-    std::vector<std::shared_ptr<glapp::monitor>> all_monitors() const;
 };
 
 class error {
@@ -1640,14 +5060,36 @@ private:
     }
 };
 
+enum class run_mode {
+    // Draw all windows on the main thread in between polling events
+    single_thread,
+
+    // Draw all windows on an individual drawing thread while the main thread waits for events
+    drawing_thread,
+
+    // Draw each window on its own render thread which keeps the context of the window current
+    thread_per_window
+};
+
 class app : internal::noncopyable {
     friend window;
 
 private:
     std::mutex mtx_;
+    // Locked while drawing windows not to destroy them during drawing
+    std::mutex draw_mtx_;
     std::vector<std::shared_ptr<glapp::window>> windows_;
-    std::unordered_map<GLFWmonitor*, std::shared_ptr<glapp::monitor>> monitors_;
-    std::atomic<bool> drawing_;
+    // Replaced as a whole on connecting or disconnecting a monitor, so that it can be read from any thread without locking
+    std::shared_ptr<const std::vector<std::shared_ptr<glapp::monitor>>> monitors_;
+    std::atomic<bool> drawing_ {};
+    // Wakes up the drawing thread of `glapp::run_mode::drawing_thread`
+    const std::shared_ptr<internal::wake_signal> drawing_signal_ = std::make_shared<internal::wake_signal>();
+    std::atomic<bool> vsync_scheduling_ { true };
+    // Functions posted by `post` to run on the thread processing events
+    internal::mpsc_queue<std::function<void()>> tasks_;
+    std::atomic<double> task_budget_ { 0.002 };
+    glapp::run_mode run_mode_ = glapp::run_mode::single_thread;
+    std::string trace_file_;
 
 public:
     ~app()
@@ -1657,6 +5099,9 @@ public:
             window->destroy();
         }
         glfwTerminate();
+        if (!trace_file_.empty()) {
+            write_trace(trace_file_.c_str());
+        }
     }
 
     static std::shared_ptr<glapp::app> instance()
@@ -1697,41 +5142,132 @@ public:
         return add_window_internal(width, height, title, monitor, options);
     }
 
+    // Adds the window which is never shown and draws the frame of the size into a framebuffer object without presenting it
+    // The frames are drawn in the same way as the other windows, and can be read back by the framebuffer object
+    std::shared_ptr<glapp::window> add_headless_window(int32_t width, int32_t height, const glapp::window_options& options = {})
+    {
+        glapp::window_options headless_options = options;
+        headless_options.set_headless(true);
+        return add_window_internal(width, height, nullptr, nullptr, headless_options);
+    }
+
     int32_t run(bool use_individual_drawing_thread = false)
     {
-        drawing_ = true;
+        return run(use_individual_drawing_thread ? glapp::run_mode::drawing_thread : glapp::run_mode::single_thread);
+    }
+
+    int32_t run(glapp::run_mode mode)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            run_mode_ = mode;
+            drawing_ = true;
+            for (auto&& window : windows_) {
+                prepare_drawing(*window);
+            }
+        }
+        internal::tracer::instance().set_thread_name("main");
         std::future<void> drawloop_future;
-        if (use_individual_drawing_thread) {
+        if (mode == glapp::run_mode::drawing_thread) {
             drawloop_future = std::async(std::launch::async, &app::drawloop, this);
         }
         while (!windows_.empty()) {
-            if (use_individual_drawing_thread) {
-                glfwWaitEvents();
+            if (mode == glapp::run_mode::single_thread) {
+                const auto next_frame_time = draw_windows();
+                wait_events_until(next_frame_time);
             } else {
-                draw_windows();
-                glfwPollEvents();
+                GLAPP_ZONE("wait_events");
+                glfwWaitEvents();
             }
+            run_tasks();
 
             // Destroy and remove closed window
-            std::lock_guard<std::mutex> lock(mtx_);
-            for (auto&& window : windows_) {
-                if (window->should_close()) {
+            std::vector<std::shared_ptr<glapp::window>> closed_windows;
+            {
+                std::lock_guard<std::mutex> lock(mtx_);
+                for (auto&& window : windows_) {
+                    if (window->should_close()) {
+                        closed_windows.push_back(window);
+                    }
+                }
+                // Erase remove idiom
+                windows_.erase(
+                    std::remove_if(
+                        windows_.begin(),
+                        windows_.end(),
+                        [](std::shared_ptr<glapp::window> window) { return window->should_close(); }),
+                    windows_.end());
+                // Sampled under the lock, since the windows may be added on another thread
+                GLAPP_COUNTER("windows", windows_.size());
+            }
+            if (!closed_windows.empty()) {
+                // The callbacks on destroying are called without locking `mtx_`
+                std::lock_guard<std::mutex> lock(draw_mtx_);
+                GLAPP_ZONE("destroy_windows");
+                for (auto&& window : closed_windows) {
                     window->destroy();
                 }
             }
-            // Erase remove idiom
-            windows_.erase(
-                std::remove_if(
-                    windows_.begin(),
-                    windows_.end(),
-                    [](std::shared_ptr<glapp::window> window) { return !(window && *window); }),
-                windows_.end());
         }
         drawing_ = false;
+        drawing_signal_->notify();
         return 0;
         // Blocked until drawloop is finished by destructor of 'drawloop_future'
     }
 
+    // Starts recording the trace of processing events and drawing windows on all threads
+    // The zones and counters of the application can be recorded by 'GLAPP_ZONE' and 'GLAPP_COUNTER'
+    void start_trace() { internal::tracer::instance().set_enabled(true); }
+    void stop_trace() { internal::tracer::instance().set_enabled(false); }
+    bool tracing() const { return internal::tracer::instance().enabled(); }
+
+    // Writes the recorded trace in Chrome trace event format, which can be opened by chrome://tracing or Perfetto UI
+    // The written events are removed, so that the trace can be written periodically without duplication
+    // Returns false if the file could not be opened
+    bool write_trace(const char* path)
+    {
+        std::ofstream file(internal::or_empty(path));
+        if (!file) {
+            return false;
+        }
+        internal::tracer::instance().write_json(file);
+        return static_cast<bool>(file);
+    }
+
+    // Returns the number of trace records dropped since the program started, because a thread recorded faster than the trace was written
+    int64_t dropped_trace_records() const { return static_cast<int64_t>(internal::tracer::instance().dropped_count()); }
+
+    // Specifies the file to which the trace is written on exit, or nullptr not to write it
+    void set_trace_file(const char* path) { trace_file_ = internal::or_empty(path); }
+
+    // Specifies whether to schedule the presentation of vsynced windows drawn in series
+    // When enabled, only one vsynced window blocks in the swap per frame and the others are presented with interval 0,
+    // so that every window keeps up with the refresh rate of the monitor
+    // Windows drawn by `glapp::run_mode::thread_per_window` are not affected
+    void set_vsync_scheduling(bool enable)
+    {
+        vsync_scheduling_ = enable;
+    }
+    bool vsync_scheduling() const { return vsync_scheduling_; }
+
+    // Runs the function on the thread processing events, where the functions of the windows restricted to the main thread can be called
+    // This function can be called from any thread, and the functions run in the posted order
+    void post(std::function<void()> task)
+    {
+        tasks_.push(std::move(task));
+        // Wake up the event loop waiting for events
+        glfwPostEmptyEvent();
+    }
+
+    // Limits the time spent on the posted functions in an iteration of the event loop, so that events are not delayed by them
+    // The rest of the functions run in the next iteration, at least one function runs in an iteration
+    // seconds - time budget per iteration
+    void set_task_budget(double seconds)
+    {
+        task_budget_ = (0.0 < seconds) ? seconds : 0.0;
+    }
+    double task_budget() const { return task_budget_; }
+
     void exit()
     {
         std::lock_guard<std::mutex> lock(mtx_);
@@ -1757,28 +5293,26 @@ public:
     std::shared_ptr<glapp::monitor> primary_monitor()
     {
         auto glfw_monitor = glfwGetPrimaryMonitor();
-        auto iter = monitors_.find(glfw_monitor);
-        if (iter != monitors_.end()) {
-            // Create a reference instances
-            return iter->second;
-        } else {
-            return {};
+        const auto monitors = std::atomic_load(&monitors_);
+        for (auto&& monitor : *monitors) {
+            if (monitor->glfw_handle() == glfw_monitor) {
+                return monitor;
+            }
         }
+        return {};
     }
 
     // Returns connected monitors
     std::vector<std::shared_ptr<glapp::monitor>> all_monitors()
     {
-        std::vector<std::shared_ptr<glapp::monitor>> monitors;
-        for (auto&& monitor : monitors_) {
-            monitors.push_back(monitor.second);
-        }
-        return monitors;
+        return *std::atomic_load(&monitors_);
     }
 
 private:
     app()
     {
+        // Construct the tracer first so that it outlives the app writing the trace on exit
+        (void)internal::tracer::instance();
         auto status = glfwInit();
         assert(status == GLFW_TRUE);
 
@@ -1787,30 +5321,51 @@ private:
 
     static void glfw_monitor_callback(GLFWmonitor* glfw_monitor, int event)
     {
+        (void)glfw_monitor;
+        (void)event;
         auto app = instance();
         assert(app);
-        auto iter = app->monitors_.find(glfw_monitor);
-        if (iter != app->monitors_.end()) {
-            iter->second->destroy();
-            app->monitors_.erase(iter);
-        }
-
-        if (event == GLFW_CONNECTED) {
-            app->monitors_[glfw_monitor] = std::shared_ptr<glapp::monitor>(new glapp::monitor(glfw_monitor)); // std::make_shared<glfw_monitor_handle>(glfw_monitor, nullptr);
-        } else if (event == GLFW_DISCONNECTED) {
-            // Nothing to do
-        } else {
-        }
+        app->update_monitors();
     }
 
     void init_monitors()
     {
         glfwSetMonitorCallback(glfw_monitor_callback);
+        update_monitors();
+        assert(!monitors_->empty());
+    }
+
+    // Publishes the list of monitors currently connected
+    // The instances of the monitors still connected are kept with the refreshed properties
+    void update_monitors()
+    {
+        const auto old_monitors = std::atomic_load(&monitors_);
+        auto new_monitors = std::make_shared<std::vector<std::shared_ptr<glapp::monitor>>>();
         int count = 0;
         auto glfw_monitors = glfwGetMonitors(&count);
-        assert(0 < count);
         for (int i = 0; i < count; ++i) {
-            monitors_[glfw_monitors[i]] = std::shared_ptr<glapp::monitor>(new glapp::monitor(glfw_monitors[i]));
+            std::shared_ptr<glapp::monitor> monitor;
+            if (old_monitors) {
+                for (auto&& old_monitor : *old_monitors) {
+                    if (old_monitor->glfw_handle() == glfw_monitors[i]) {
+                        monitor = old_monitor;
+                        monitor->refresh();
+                        break;
+                    }
+                }
+            }
+            if (!monitor) {
+                monitor = std::shared_ptr<glapp::monitor>(new glapp::monitor(glfw_monitors[i]));
+            }
+            new_monitors->push_back(monitor);
+        }
+        std::atomic_store(&monitors_, std::shared_ptr<const std::vector<std::shared_ptr<glapp::monitor>>>(new_monitors));
+        if (old_monitors) {
+            for (auto&& old_monitor : *old_monitors) {
+                if (std::find(new_monitors->begin(), new_monitors->end(), old_monitor) == new_monitors->end()) {
+                    old_monitor->destroy();
+                }
+            }
         }
     }
 
@@ -1820,32 +5375,138 @@ private:
         auto window = std::shared_ptr<glapp::window>(new glapp::window(width, height, title, monitor, options));
         if (window && *window) {
             windows_.emplace_back(window);
+            if (drawing_) {
+                prepare_drawing(*window);
+            }
         } else {
             window = nullptr;
         }
         return window;
     }
 
+    // Must be called with locking `mtx_`
+    void prepare_drawing(glapp::window& window)
+    {
+        if (run_mode_ != glapp::run_mode::single_thread) {
+            // The window is drawn in another thread than the thread processing events
+            window.event_queue_.reset(new internal::spsc_queue<glapp::window::queued_event>());
+        }
+        if (run_mode_ == glapp::run_mode::drawing_thread) {
+            std::atomic_store(&window.drawing_signal_, drawing_signal_);
+            // Draw the first frame of the window added while the drawing thread is waiting
+            drawing_signal_->notify();
+        } else if (run_mode_ == glapp::run_mode::thread_per_window) {
+            window.start_render_thread();
+        }
+    }
+
     void drawloop()
     {
+        internal::tracer::instance().set_thread_name("drawing");
         while (drawing_) {
-            draw_windows();
-            std::this_thread::yield();
+            const auto next_frame_time = draw_windows();
+            if (internal::clock::now() < next_frame_time) {
+                // Sleep until any frame is due, or until woken up by invalidation, events, closing or the end of drawing
+                drawing_signal_->wait_until(next_frame_time);
+            } else {
+                // Let the thread processing events run between the frames drawn back to back
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Runs the posted functions within the time budget
+    void run_tasks()
+    {
+        std::function<void()> task;
+        if (!tasks_.pop(task)) {
+            return;
+        }
+        GLAPP_ZONE("run_tasks");
+        const auto deadline = internal::clock::now() + std::chrono::duration_cast<internal::clock::duration>(std::chrono::duration<double>(task_budget_));
+        do {
+            task();
+            if (deadline <= internal::clock::now()) {
+                // Do not wait for events in the next iteration to run the rest
+                glfwPostEmptyEvent();
+                break;
+            }
+        } while (tasks_.pop(task));
+    }
+
+    // Processes events until the specified time, or until any event has been processed
+    // deadline - `time_point::max()` to wait without timeout
+    void wait_events_until(internal::clock::time_point deadline)
+    {
+        // The waiting period for events which is too short for the precision of the timeout
+        constexpr internal::clock::duration spin = std::chrono::milliseconds(2);
+        GLAPP_ZONE("wait_events");
+        const auto now = internal::clock::now();
+        if (deadline == internal::clock::time_point::max()) {
+            glfwWaitEvents();
+        } else if (deadline <= now) {
+            glfwPollEvents();
+        } else if (deadline - now <= spin) {
+            internal::precise_sleep_until(deadline);
+            glfwPollEvents();
+        } else {
+            glfwWaitEventsTimeout(std::chrono::duration<double>(deadline - now - spin).count());
         }
     }
 
-    void draw_windows()
+    // Draws the windows whose frame is due
+    // Returns the earliest time at which the next frame of any window should be drawn
+    internal::clock::time_point draw_windows()
     {
+        std::lock_guard<std::mutex> draw_lock(draw_mtx_);
         std::vector<std::shared_ptr<glapp::window>> windows;
+        const auto now = internal::clock::now();
+        auto next_frame_time = internal::clock::time_point::max();
         {
             std::lock_guard<std::mutex> lock(mtx_);
             for (auto&& window : windows_) {
-                windows.push_back(window);
+                if (window->next_frame_time() <= now) {
+                    windows.push_back(window);
+                } else {
+                    next_frame_time = (std::min)(next_frame_time, window->next_frame_time());
+                }
             }
         }
+        const auto pacer = vsync_scheduling_ ? vsync_pacer(windows) : nullptr;
         for (auto&& window : windows) {
-            window->draw();
+            if (window != pacer) {
+                window->draw(pacer ? 0 : window->swap_interval_);
+            }
+        }
+        // Block on the vblank once after all other windows have been presented
+        if (pacer) {
+            pacer->draw(pacer->swap_interval_);
+        }
+        for (auto&& window : windows) {
+            next_frame_time = (std::min)(next_frame_time, window->next_frame_time());
+        }
+        return next_frame_time;
+    }
+
+    // Returns the vsynced window placed on the monitor with the highest refresh rate
+    // Returns nullptr if there is less than two vsynced windows, as no scheduling is required
+    static std::shared_ptr<glapp::window> vsync_pacer(const std::vector<std::shared_ptr<glapp::window>>& windows)
+    {
+        std::shared_ptr<glapp::window> pacer;
+        int32_t vsynced_count = 0;
+        int32_t max_refresh_rate = -1;
+        for (auto&& window : windows) {
+            if (0 < window->swap_interval_ && !window->headless_) {
+                ++vsynced_count;
+                const auto monitor = window->placed_monitor_internal();
+                const int32_t refresh_rate = monitor ? monitor->refresh_rate() : 0;
+                if (max_refresh_rate < refresh_rate) {
+                    max_refresh_rate = refresh_rate;
+                    pacer = window;
+                }
+            }
         }
+        return (2 <= vsynced_count) ? pacer : nullptr;
     }
 };
 
@@ -1854,14 +5515,22 @@ std::shared_ptr<glapp::app> get()
     return glapp::app::instance();
 }
 
-inline std::vector<std::shared_ptr<glapp::monitor>> glapp::window::all_monitors() const
+inline std::shared_ptr<const std::vector<std::shared_ptr<glapp::monitor>>> glapp::window::connected_monitors()
 {
-    std::vector<std::shared_ptr<glapp::monitor>> monitors;
     auto app = glapp::app::instance();
-    if (app) {
-        monitors = app->all_monitors();
+    return app ? std::atomic_load(&app->monitors_) : nullptr;
+}
+
+inline void glapp::window::refresh_monitor(GLFWmonitor* glfw_monitor)
+{
+    const auto monitors = connected_monitors();
+    if (monitors) {
+        for (auto&& monitor : *monitors) {
+            if (monitor->glfw_handle() == glfw_monitor) {
+                monitor->refresh();
+            }
+        }
     }
-    return monitors;
 }
 
 } // namespace glapp
@@ -351,3 +351,918 @@ TEST_F(GlapTest, WindowSizeAspectRatio)
     EXPECT_EQ(w->size().width(), 300);
     EXPECT_EQ(w->size().height(), 300);
 }
+
+TEST_F(GlapTest, RenderThreadPerWindow)
+{
+    auto app = glapp::get();
+    auto w1 = app->add_window(320, 240, nullptr);
+    auto w2 = app->add_window(320, 240, nullptr);
+    const auto main_thread_id = std::this_thread::get_id();
+    std::thread::id thread_id1 {};
+    std::thread::id thread_id2 {};
+    auto frame = [&](glapp::window& window, std::thread::id& thread_id) {
+        // The context stays current on the render thread
+        EXPECT_EQ(glfwGetCurrentContext(), window.glfw_handle());
+        EXPECT_NE(std::this_thread::get_id(), main_thread_id);
+        if (window.frame_count() == 0) {
+            thread_id = std::this_thread::get_id();
+        } else {
+            EXPECT_EQ(std::this_thread::get_id(), thread_id);
+        }
+        if (window.frame_count() == 9) {
+            window.close();
+        }
+    };
+    w1->on_frame([&](glapp::window& window) { frame(window, thread_id1); });
+    w2->on_frame([&](glapp::window& window) { frame(window, thread_id2); });
+    app->run(glapp::run_mode::thread_per_window);
+    EXPECT_NE(thread_id1, thread_id2);
+    EXPECT_EQ(w1->frame_count(), 10);
+    EXPECT_EQ(w2->frame_count(), 10);
+}
+
+TEST_F(GlapTest, ExitFromRenderThread)
+{
+    auto app = glapp::get();
+    auto w1 = app->add_window(320, 240, nullptr);
+    auto w2 = app->add_window(320, 240, nullptr);
+    w1->on_frame([&](glapp::window& window) {
+        if (window.frame_count() == 3) {
+            window.close();
+            // Give the event loop time to start destroying the window, which joins this thread
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            app->exit();
+        }
+    });
+    app->run(glapp::run_mode::thread_per_window);
+    EXPECT_TRUE(w1->should_close());
+    EXPECT_TRUE(w2->should_close());
+}
+
+TEST_F(GlapTest, VsyncScheduling)
+{
+    auto app = glapp::get();
+    EXPECT_TRUE(app->vsync_scheduling());
+    app->set_vsync_scheduling(false);
+    EXPECT_FALSE(app->vsync_scheduling());
+    app->set_vsync_scheduling(true);
+    EXPECT_TRUE(app->vsync_scheduling());
+    auto w1 = app->add_window(320, 240, nullptr);
+    auto w2 = app->add_window(320, 240, nullptr);
+    auto headless = app->add_headless_window(320, 240);
+    std::vector<glapp::window*> drawn;
+    for (auto&& w : { w1, w2, headless }) {
+        w->set_swap_interval(1);
+        w->on_frame([&](glapp::window& window) {
+            drawn.push_back(&window);
+            if (window.frame_count() == 9) {
+                window.close();
+            }
+        });
+    }
+    app->run();
+    EXPECT_EQ(w1->frame_count(), 10);
+    EXPECT_EQ(w2->frame_count(), 10);
+    EXPECT_EQ(headless->frame_count(), 10);
+    ASSERT_EQ(drawn.size(), 30u);
+    for (size_t i = 0; i < drawn.size(); i += 3) {
+        // The pacer blocking on the vblank is drawn last, which is one of the windows presenting the frame
+        EXPECT_NE(drawn[i + 2], headless.get());
+    }
+}
+
+TEST_F(GlapTest, TargetFps)
+{
+    auto app = glapp::get();
+    auto w = app->add_window(320, 240, nullptr);
+    EXPECT_EQ(w->target_fps(), 0.0);
+    w->set_target_fps(30.0);
+    EXPECT_EQ(w->target_fps(), 30.0);
+    w->on_frame([&](glapp::window& window) {
+        if (window.frame_count() == 15) {
+            window.close();
+        }
+    });
+    const double start = app->get_time();
+    app->run();
+    // 15 intervals of 1/30 seconds between the first and the last frame
+    EXPECT_GE(app->get_time() - start, 0.49);
+    EXPECT_LT(app->get_time() - start, 2.0);
+}
+
+TEST_F(GlapTest, RenderOnDemand)
+{
+    auto app = glapp::get();
+    auto w = app->add_window(320, 240, nullptr);
+    EXPECT_EQ(w->render_mode(), glapp::render_mode::continuous);
+    w->set_render_mode(glapp::render_mode::on_demand);
+    EXPECT_EQ(w->render_mode(), glapp::render_mode::on_demand);
+    std::atomic<bool> invalidated_by_thread { false };
+    std::thread thread;
+    w->on_frame([&](glapp::window& window) {
+        if (window.frame_count() == 0) {
+            thread = std::thread([&]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                invalidated_by_thread = true;
+                window.invalidate();
+            });
+        } else if (invalidated_by_thread) {
+            window.close();
+        }
+    });
+    app->run();
+    thread.join();
+    // Only a few frames are drawn for the events on creating the window
+    EXPECT_LT(w->frame_count(), 10);
+}
+
+TEST_F(GlapTest, RenderOnDemandInDrawingThreads)
+{
+    auto app = glapp::get();
+    for (auto mode : { glapp::run_mode::drawing_thread, glapp::run_mode::thread_per_window }) {
+        auto w = app->add_window(320, 240, nullptr);
+        w->set_render_mode(glapp::render_mode::on_demand);
+        std::atomic<double> invalidated_time { 0.0 };
+        double wakeup_latency = -1.0;
+        std::thread thread;
+        w->on_frame([&](glapp::window& window) {
+            if (window.frame_count() == 0) {
+                thread = std::thread([&]() {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                    invalidated_time = app->get_time();
+                    window.invalidate();
+                });
+            } else if (0.0 < invalidated_time) {
+                wakeup_latency = app->get_time() - invalidated_time;
+                window.close();
+            }
+        });
+        app->run(mode);
+        thread.join();
+        // The sleeping drawing thread is woken up by the invalidation
+        // The bound is generous not to depend on the scheduling of the loaded machine
+        EXPECT_GE(wakeup_latency, 0.0);
+        EXPECT_LT(wakeup_latency, 1.0);
+        EXPECT_LT(w->frame_count(), 10);
+    }
+}
+
+TEST_F(GlapTest, CancelCloseInDrawingThreads)
+{
+    auto app = glapp::get();
+    for (auto mode : { glapp::run_mode::drawing_thread, glapp::run_mode::thread_per_window }) {
+        auto w = app->add_window(320, 240, nullptr);
+        int32_t close_count = 0;
+        std::thread::id close_thread_id {};
+        w->on_window_close([&](glapp::window& window) {
+            close_thread_id = std::this_thread::get_id();
+            if (++close_count == 1) {
+                glfwSetWindowShouldClose(window.glfw_handle(), GLFW_FALSE);
+            }
+        });
+        auto close_callback = glfwSetWindowCloseCallback(w->glfw_handle(), nullptr);
+        ASSERT_NE(close_callback, nullptr);
+        glfwSetWindowCloseCallback(w->glfw_handle(), close_callback);
+        std::atomic<bool> canceled { false };
+        w->on_frame([&](glapp::window& window) {
+            if (window.frame_count() == 0) {
+                app->post([&]() {
+                    // Simulate clicking the close button, for which GLFW sets the flag before calling the callback
+                    glfwSetWindowShouldClose(w->glfw_handle(), GLFW_TRUE);
+                    close_callback(w->glfw_handle());
+                    canceled = true;
+                });
+            } else if (canceled && 10 <= window.frame_count()) {
+                window.close();
+            }
+        });
+        app->run(mode);
+        // The window is closed by 'close' after the canceled closing
+        EXPECT_EQ(close_count, 1);
+        EXPECT_EQ(close_thread_id, std::this_thread::get_id());
+        EXPECT_GT(w->frame_count(), 10);
+    }
+}
+
+TEST_F(GlapTest, FixedUpdate)
+{
+    auto app = glapp::get();
+    auto w = app->add_window(320, 240, nullptr);
+    EXPECT_EQ(w->update_rate(), 60.0);
+    w->set_update_rate(120.0);
+    w->set_target_fps(30.0);
+    int update_count = 0;
+    w->on_update([&](glapp::window&, double dt) {
+        EXPECT_DOUBLE_EQ(dt, 1.0 / 120.0);
+        ++update_count;
+    });
+    w->on_frame([&](glapp::window& window, double alpha) {
+        EXPECT_GE(alpha, 0.0);
+        EXPECT_LT(alpha, 1.0);
+        if (window.frame_count() == 15) {
+            window.close();
+        }
+    });
+    app->run();
+    // About 4 updates per frame for 0.5 seconds
+    EXPECT_GT(update_count, 40);
+    EXPECT_LT(update_count, 80);
+}
+
+TEST_F(GlapTest, EventOnDrawingThread)
+{
+    auto app = glapp::get();
+    auto w = app->add_window(320, 240, nullptr);
+    w->set_pos(200, 100);
+    std::thread::id frame_thread_id {};
+    std::thread::id event_thread_id {};
+    w->on_frame([&](glapp::window& window) {
+        frame_thread_id = std::this_thread::get_id();
+        if (window.frame_count() == 300) {
+            window.close();
+        }
+    });
+    w->on_window_pos([&](glapp::window& window, int32_t, int32_t) {
+        event_thread_id = std::this_thread::get_id();
+        window.close();
+    });
+    app->run(true);
+    // Events are delivered on the drawing thread
+    EXPECT_NE(event_thread_id, std::thread::id {});
+    EXPECT_EQ(event_thread_id, frame_thread_id);
+}
+
+TEST_F(GlapTest, PostTask)
+{
+    auto app = glapp::get();
+    auto w = app->add_window(320, 240, nullptr);
+    EXPECT_DOUBLE_EQ(app->task_budget(), 0.002);
+    app->set_task_budget(0.0);
+    const auto main_thread_id = std::this_thread::get_id();
+    std::vector<int32_t> done;
+    std::vector<std::thread> threads;
+    w->on_frame([&](glapp::window& window) {
+        if (window.frame_count() == 0) {
+            for (int32_t i = 0; i < 4; ++i) {
+                threads.emplace_back([&, i]() {
+                    for (int32_t j = 0; j < 100; ++j) {
+                        app->post([&, i, j]() {
+                            // Tasks from a thread run in the posted order on the main thread
+                            EXPECT_EQ(std::this_thread::get_id(), main_thread_id);
+                            EXPECT_EQ(std::count(done.begin(), done.end(), i), j);
+                            done.push_back(i);
+                            if (done.size() == 400) {
+                                window.set_title("done");
+                                window.close();
+                            }
+                        });
+                    }
+                });
+            }
+        }
+    });
+    app->run(true);
+    for (auto&& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(done.size(), 400u);
+    EXPECT_STREQ(w->title().c_str(), "done");
+}
+
+TEST_F(GlapTest, EventCoalescing)
+{
+    auto app = glapp::get();
+    auto w = app->add_window(320, 240, nullptr);
+    EXPECT_EQ(w->coalescing(glapp::coalescible_event::window_pos), glapp::coalescing::none);
+    w->set_coalescing(glapp::coalescible_event::window_pos, glapp::coalescing::latest);
+    EXPECT_EQ(w->coalescing(glapp::coalescible_event::window_pos), glapp::coalescing::latest);
+    int window_pos_count = 0;
+    int32_t window_pos_xpos = 0;
+    int32_t window_pos_ypos = 0;
+    w->on_window_pos([&](glapp::window&, int32_t xpos, int32_t ypos) {
+        ++window_pos_count;
+        window_pos_xpos = xpos;
+        window_pos_ypos = ypos;
+    });
+    w->on_frame([&](glapp::window& window) {
+        if (window.frame_count() == 0) {
+            window.set_pos(100, 100);
+            window.set_pos(150, 100);
+            window.set_pos(200, 100);
+        } else if (window_pos_xpos == 200 || window.frame_count() == 300) {
+            window.close();
+        }
+    });
+    app->run();
+    // Only the latest position is delivered for the moves in a frame
+    EXPECT_LT(window_pos_count, 3);
+    EXPECT_EQ(window_pos_xpos, 200);
+    EXPECT_EQ(window_pos_ypos, 100);
+}
+
+TEST_F(GlapTest, KeyName)
+{
+    static_assert(glapp::key_name(glapp::key::space)[0] == 's', "key_name must be constexpr");
+    EXPECT_STREQ(glapp::key_name(glapp::key::a), "a");
+    EXPECT_STREQ(glapp::key_name(glapp::key::digit0), "0");
+    EXPECT_STREQ(glapp::key_name(glapp::key::f11), "f11");
+    EXPECT_STREQ(glapp::key_name(glapp::key::escape), "escape");
+    EXPECT_STREQ(glapp::key_name(glapp::key::num9), "num9");
+    EXPECT_STREQ(glapp::key_name(glapp::key::numenter), "enter");
+    EXPECT_STREQ(glapp::key_name(glapp::key::rsuper), "rsuper");
+    EXPECT_STREQ(glapp::key_name(glapp::key::comma), "");
+    EXPECT_STREQ(glapp::key_name(glapp::key::unknown), "");
+    EXPECT_STREQ(glapp::mouse_button_name(glapp::mouse_button::left), "left");
+    EXPECT_STREQ(glapp::mouse_button_name(glapp::mouse_button::middle), "middle");
+    EXPECT_STREQ(glapp::mouse_button_name(glapp::mouse_button::button8), "");
+}
+
+TEST_F(GlapTest, Subscription)
+{
+    auto app = glapp::get();
+    auto w = app->add_window(320, 240, nullptr);
+    // Closing callback is installed on subscribing
+    auto close_callback = glfwSetWindowCloseCallback(w->glfw_handle(), nullptr);
+    EXPECT_EQ(close_callback, nullptr);
+    glfwSetWindowCloseCallback(w->glfw_handle(), close_callback);
+    int32_t first_count = 0;
+    int32_t second_count = 0;
+    int32_t third_count = 0;
+    auto first = w->on_frame([&](glapp::window&) { ++first_count; });
+    glapp::subscription third;
+    w->on_frame([&](glapp::window& window) {
+        ++second_count;
+        if (window.frame_count() == 1) {
+            EXPECT_TRUE(window.unsubscribe(first));
+            EXPECT_FALSE(window.unsubscribe(first));
+            EXPECT_TRUE(window.unsubscribe(third));
+        } else if (window.frame_count() == 3) {
+            window.close();
+        }
+    });
+    third = w->on_frame([&](glapp::window&) { ++third_count; });
+    EXPECT_TRUE(first);
+    EXPECT_TRUE(third);
+    EXPECT_FALSE(glapp::subscription());
+    w->on_window_close([](glapp::window&) {});
+    close_callback = glfwSetWindowCloseCallback(w->glfw_handle(), nullptr);
+    EXPECT_NE(close_callback, nullptr);
+    glfwSetWindowCloseCallback(w->glfw_handle(), close_callback);
+    // The subscription to another window is not removed
+    auto other = app->add_window(320, 240, nullptr);
+    // Passing nullptr removes all the callbacks of the event
+    int32_t cleared_count = 0;
+    other->on_frame([&](glapp::window&) { ++cleared_count; });
+    EXPECT_FALSE(other->on_frame(nullptr));
+    int32_t other_count = 0;
+    auto other_subscription = other->on_frame([&](glapp::window& window) {
+        ++other_count;
+        window.close();
+    });
+    EXPECT_FALSE(w->unsubscribe(other_subscription));
+    EXPECT_FALSE(other->unsubscribe(first));
+    app->run();
+    EXPECT_EQ(other_count, 1);
+    EXPECT_EQ(cleared_count, 0);
+    EXPECT_EQ(first_count, 2);
+    EXPECT_EQ(second_count, 4);
+    // Removed while dispatching, so that it is not called in the same frame
+    EXPECT_EQ(third_count, 1);
+}
+
+TEST_F(GlapTest, DropPaths)
+{
+    auto app = glapp::get();
+    auto w = app->add_window(320, 240, nullptr);
+    std::vector<std::string> span_paths;
+    w->on_drop([&](glapp::window&, const glapp::path_span& paths) {
+        for (auto path : paths) {
+            span_paths.push_back(path);
+        }
+    });
+    std::vector<std::string> vector_paths;
+    w->on_drop([&](glapp::window&, const std::vector<std::string>& paths) {
+        vector_paths = paths;
+    });
+    // Simulate dropping by calling the installed GLFW callback
+    auto drop_callback = glfwSetDropCallback(w->glfw_handle(), nullptr);
+    ASSERT_NE(drop_callback, nullptr);
+    glfwSetDropCallback(w->glfw_handle(), drop_callback);
+    const char* paths[] = { "/tmp/a.txt", "/tmp/b.txt" };
+    drop_callback(w->glfw_handle(), 2, paths);
+    const std::vector<std::string> expected { "/tmp/a.txt", "/tmp/b.txt" };
+    EXPECT_EQ(span_paths, expected);
+    EXPECT_EQ(vector_paths, expected);
+}
+
+TEST_F(GlapTest, InputState)
+{
+    auto app = glapp::get();
+    auto w = app->add_window(320, 240, nullptr);
+    // Simulate the input by calling the installed GLFW callbacks
+    auto key_callback = glfwSetKeyCallback(w->glfw_handle(), nullptr);
+    auto scroll_callback = glfwSetScrollCallback(w->glfw_handle(), nullptr);
+    ASSERT_NE(key_callback, nullptr);
+    ASSERT_NE(scroll_callback, nullptr);
+    glfwSetKeyCallback(w->glfw_handle(), key_callback);
+    glfwSetScrollCallback(w->glfw_handle(), scroll_callback);
+    w->on_frame([&](glapp::window& window) {
+        const auto& input = window.input();
+        if (window.frame_count() == 0) {
+            EXPECT_FALSE(input.key_pressed(glapp::key::a));
+            key_callback(window.glfw_handle(), GLFW_KEY_A, 0, GLFW_PRESS, GLFW_MOD_SHIFT);
+            scroll_callback(window.glfw_handle(), 0.0, 1.0);
+            scroll_callback(window.glfw_handle(), 0.0, 2.0);
+            // The snapshot is not changed until the next frame
+            EXPECT_FALSE(input.key_pressed(glapp::key::a));
+        } else if (window.frame_count() == 1) {
+            EXPECT_TRUE(input.key_pressed(glapp::key::a));
+            EXPECT_TRUE(input.modifier().shift());
+            EXPECT_EQ(input.scroll().y(), 3.0);
+            key_callback(window.glfw_handle(), GLFW_KEY_A, 0, GLFW_RELEASE, 0);
+        } else {
+            EXPECT_FALSE(input.key_pressed(glapp::key::a));
+            EXPECT_EQ(input.scroll().y(), 0.0);
+            window.close();
+        }
+    });
+    app->run();
+    EXPECT_EQ(w->frame_count(), 3);
+}
+
+TEST_F(GlapTest, CachedGeometry)
+{
+    auto app = glapp::get();
+    auto w = app->add_window(320, 240, nullptr);
+    EXPECT_EQ(w->size().width(), 320);
+    EXPECT_EQ(w->size().height(), 240);
+    EXPECT_EQ(w->state(), glapp::window_state::normal);
+    // Simulate the changes by the window manager by calling the installed GLFW callbacks
+    auto pos_callback = glfwSetWindowPosCallback(w->glfw_handle(), nullptr);
+    auto size_callback = glfwSetWindowSizeCallback(w->glfw_handle(), nullptr);
+    auto framebuffer_size_callback = glfwSetFramebufferSizeCallback(w->glfw_handle(), nullptr);
+    ASSERT_NE(pos_callback, nullptr);
+    ASSERT_NE(size_callback, nullptr);
+    ASSERT_NE(framebuffer_size_callback, nullptr);
+    glfwSetWindowPosCallback(w->glfw_handle(), pos_callback);
+    glfwSetWindowSizeCallback(w->glfw_handle(), size_callback);
+    glfwSetFramebufferSizeCallback(w->glfw_handle(), framebuffer_size_callback);
+    pos_callback(w->glfw_handle(), 300, 150);
+    size_callback(w->glfw_handle(), 400, 300);
+    framebuffer_size_callback(w->glfw_handle(), 800, 600);
+    EXPECT_EQ(w->pos().x(), 300);
+    EXPECT_EQ(w->pos().y(), 150);
+    EXPECT_EQ(w->size().width(), 400);
+    EXPECT_EQ(w->size().height(), 300);
+    EXPECT_EQ(w->framebuffer_size().width(), 800);
+    EXPECT_EQ(w->framebuffer_size().height(), 600);
+}
+
+TEST_F(GlapTest, MonitorCache)
+{
+    auto app = glapp::get();
+    const auto monitor = app->primary_monitor();
+    ASSERT_TRUE(monitor);
+    const auto glfw_mode = glfwGetVideoMode(monitor->glfw_handle());
+    ASSERT_NE(glfw_mode, nullptr);
+    EXPECT_EQ(monitor->rect().width(), glfw_mode->width);
+    EXPECT_EQ(monitor->rect().height(), glfw_mode->height);
+    EXPECT_EQ(monitor->refresh_rate(), glfw_mode->refreshRate);
+    // Same instances are returned until the monitors are changed
+    const auto monitors = app->all_monitors();
+    EXPECT_NE(std::find(monitors.begin(), monitors.end(), monitor), monitors.end());
+    auto w = app->add_window(320, 240, nullptr);
+    const auto placed_monitor = w->placed_monitor();
+    EXPECT_NE(std::find(monitors.begin(), monitors.end(), placed_monitor), monitors.end());
+}
+
+TEST_F(GlapTest, FrameStats)
+{
+    auto app = glapp::get();
+    auto w = app->add_window(320, 240, nullptr);
+    w->set_target_fps(100.0);
+    EXPECT_EQ(w->frame_stats().sample_count(), 0u);
+    w->on_frame([](glapp::window& window) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (window.frame_count() == 19) {
+            window.close();
+        }
+    });
+    app->run();
+    const auto stats = w->frame_stats();
+    EXPECT_EQ(stats.sample_count(), 20u);
+    EXPECT_GE(stats.cpu_time().min(), 0.001);
+    EXPECT_LE(stats.cpu_time().min(), stats.cpu_time().p50());
+    EXPECT_LE(stats.cpu_time().p50(), stats.cpu_time().p95());
+    EXPECT_LE(stats.cpu_time().p95(), stats.cpu_time().p99());
+    EXPECT_LE(stats.cpu_time().p99(), stats.cpu_time().max());
+    EXPECT_NEAR(stats.interval().avg(), 0.01, 0.005);
+    EXPECT_NEAR(stats.fps(), 100.0, 50.0);
+}
+
+TEST_F(GlapTest, GpuTiming)
+{
+    auto app = glapp::get();
+    auto w = app->add_window(320, 240, nullptr);
+    EXPECT_FALSE(w->gpu_timing_enabled());
+    w->set_gpu_timing(true);
+    int64_t measured_count = 0;
+    w->on_frame([&](glapp::window& window) {
+        {
+            glapp::gpu_zone outer(window, "outer");
+            glapp::gpu_zone inner(window, "inner");
+        }
+        const auto& timing = window.gpu_timing();
+        if (timing) {
+            // Results are read after the frame without waiting for GPU
+            EXPECT_LT(timing.frame_count(), window.frame_count());
+            ASSERT_EQ(timing.zones().size(), 2u);
+            EXPECT_STREQ(timing.zones()[0].name(), "outer");
+            EXPECT_EQ(timing.zones()[0].depth(), 0);
+            EXPECT_STREQ(timing.zones()[1].name(), "inner");
+            EXPECT_EQ(timing.zones()[1].depth(), 1);
+            ++measured_count;
+        }
+        if (window.frame_count() == 30) {
+            window.close();
+        }
+    });
+    app->run();
+    // Disabled if the timer queries are not supported
+    if (!w->gpu_timing_enabled()) {
+        EXPECT_EQ(measured_count, 0);
+        GTEST_SKIP() << "Timer queries are not supported by the context";
+    }
+    EXPECT_LT(0, measured_count);
+}
+
+TEST_F(GlapTest, Trace)
+{
+    auto app = glapp::get();
+    auto w = app->add_window(320, 240, nullptr);
+    EXPECT_FALSE(app->tracing());
+    app->start_trace();
+    EXPECT_TRUE(app->tracing());
+    w->on_frame([](glapp::window& window) {
+        glapp::trace_scope scope("user_zone");
+        glapp::trace_scope escaped_scope("quoted \"zone\" \\ path");
+        if (window.frame_count() == 4) {
+            window.close();
+        }
+    });
+    app->run(true);
+    app->stop_trace();
+    const char* path = "glapp_test_trace.json";
+    ASSERT_TRUE(app->write_trace(path));
+    std::stringstream trace;
+    trace << std::ifstream(path).rdbuf();
+    std::remove(path);
+    const auto json = trace.str();
+    EXPECT_EQ(json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["), 0u);
+    EXPECT_NE(json.find("\"name\":\"draw\",\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"frame\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"swap\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"user_zone\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"wait_events\""), std::string::npos);
+    EXPECT_NE(json.find("\"args\":{\"name\":\"drawing\"}"), std::string::npos);
+    EXPECT_NE(json.find("\"args\":{\"window\":" + std::to_string(w->trace_id()) + "}"), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"quoted \\\"zone\\\" \\\\ path\""), std::string::npos);
+    EXPECT_EQ(app->dropped_trace_records(), 0);
+    // Written events are removed
+    ASSERT_TRUE(app->write_trace(path));
+    std::stringstream empty_trace;
+    empty_trace << std::ifstream(path).rdbuf();
+    std::remove(path);
+    EXPECT_EQ(empty_trace.str().find("\"ph\":\"X\""), std::string::npos);
+}
+
+TEST_F(GlapTest, HeadlessWindow)
+{
+    auto app = glapp::get();
+    auto w = app->add_headless_window(160, 120);
+    ASSERT_TRUE(*w);
+    EXPECT_TRUE(w->headless());
+    EXPECT_FALSE(w->visible());
+    EXPECT_EQ(w->framebuffer_size().width(), 160);
+    EXPECT_EQ(w->framebuffer_size().height(), 120);
+    int32_t frame_count = 0;
+    w->on_frame([&](glapp::window& window) {
+        ++frame_count;
+        if (window.frame_count() == 9) {
+            window.close();
+        }
+    });
+    app->run();
+    EXPECT_EQ(frame_count, 10);
+    EXPECT_EQ(w->frame_count(), 10);
+    auto normal = app->add_window(160, 120, "normal");
+    EXPECT_FALSE(normal->headless());
+    EXPECT_EQ(normal->framebuffer_id(), 0u);
+    normal->close();
+    app->run();
+}
+
+TEST_F(GlapTest, CaptureAsync)
+{
+    auto app = glapp::get();
+    auto w = app->add_headless_window(64, 32);
+    bool supported = false;
+    std::mutex mtx;
+    std::vector<int64_t> captured_frames;
+    std::vector<int64_t> shared_frames;
+    std::thread::id callback_thread;
+    size_t mismatched_pixels = 0;
+    w->on_frame([&](glapp::window& window) {
+        // Clear to the color whose components are exact in 8 bits
+        glClearColor(0.2f, 0.4f, 0.6f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        if (window.frame_count() == 0) {
+            supported = window.capture_async([&](const glapp::captured_frame& frame) {
+                std::lock_guard<std::mutex> lock(mtx);
+                captured_frames.push_back(frame.frame_count());
+                callback_thread = std::this_thread::get_id();
+                EXPECT_EQ(frame.width(), 64);
+                EXPECT_EQ(frame.height(), 32);
+                ASSERT_EQ(frame.size_in_bytes(), 64u * 32u * 4u);
+                ASSERT_NE(frame.pixels(), nullptr);
+                const uint8_t expected[] = { 51, 102, 153, 255 };
+                for (size_t i = 0; i < frame.size_in_bytes(); i += 4) {
+                    if (std::memcmp(frame.pixels() + i, expected, sizeof(expected)) != 0) {
+                        ++mismatched_pixels;
+                    }
+                }
+            });
+            // Shares the read back with the callback above
+            window.capture_async([&](const glapp::captured_frame& frame) {
+                std::lock_guard<std::mutex> lock(mtx);
+                shared_frames.push_back(frame.frame_count());
+            });
+        }
+        if (window.frame_count() == 10) {
+            window.close();
+        }
+    });
+    app->run();
+    if (!supported) {
+        EXPECT_TRUE(captured_frames.empty());
+        GTEST_SKIP() << "Capturing is not supported by the context";
+    }
+    // Delivered on the worker thread a few frames later
+    ASSERT_EQ(captured_frames.size(), 1u);
+    EXPECT_EQ(captured_frames[0], 0);
+    ASSERT_EQ(shared_frames.size(), 1u);
+    EXPECT_EQ(shared_frames[0], 0);
+    EXPECT_NE(callback_thread, std::this_thread::get_id());
+    EXPECT_EQ(mismatched_pixels, 0u);
+    EXPECT_EQ(w->dropped_capture_count(), 0);
+}
+
+TEST_F(GlapTest, RgbaToI420)
+{
+    // Odd size to convert the tails of the rows and the last row by the scalar kernels
+    const int32_t width = 37;
+    const int32_t height = 23;
+    std::vector<uint8_t> rgba(width * height * 4);
+    uint32_t seed = 1;
+    for (auto&& c : rgba) {
+        seed = seed * 1103515245 + 12345;
+        c = static_cast<uint8_t>(seed >> 16);
+    }
+    const int32_t chroma_width = (width + 1) / 2;
+    const int32_t chroma_height = (height + 1) / 2;
+    std::vector<uint8_t> y(width * height);
+    std::vector<uint8_t> u(chroma_width * chroma_height);
+    std::vector<uint8_t> v(chroma_width * chroma_height);
+    glapp::internal::rgba_to_i420(rgba.data(), width, height, 0, chroma_height, y.data(), u.data(), v.data());
+    // RGBA rows are ordered from the bottom
+    auto pixel = [&](int32_t x, int32_t row) { return &rgba[((height - 1 - (std::min)(row, height - 1)) * width + (std::min)(x, width - 1)) * 4]; };
+    for (int32_t row = 0; row < height; ++row) {
+        for (int32_t x = 0; x < width; ++x) {
+            const uint8_t* p = pixel(x, row);
+            ASSERT_EQ(y[row * width + x], ((66 * p[0] + 129 * p[1] + 25 * p[2] + 128) >> 8) + 16) << x << "," << row;
+        }
+    }
+    for (int32_t row = 0; row < chroma_height; ++row) {
+        for (int32_t x = 0; x < chroma_width; ++x) {
+            int32_t sum[3] = {};
+            for (int32_t dx = 0; dx < 2; ++dx) {
+                for (int32_t c = 0; c < 3; ++c) {
+                    sum[c] += (pixel(x * 2 + dx, row * 2)[c] + pixel(x * 2 + dx, row * 2 + 1)[c] + 1) >> 1;
+                }
+            }
+            ASSERT_EQ(u[row * chroma_width + x], ((-38 * sum[0] - 74 * sum[1] + 112 * sum[2] + 256) >> 9) + 128) << x << "," << row;
+            ASSERT_EQ(v[row * chroma_width + x], ((112 * sum[0] - 94 * sum[1] - 18 * sum[2] + 256) >> 9) + 128) << x << "," << row;
+        }
+    }
+}
+
+TEST_F(GlapTest, Recorder)
+{
+    auto app = glapp::get();
+    auto w = app->add_headless_window(64, 32);
+    const char* path = "glapp_test_recording.y4m";
+    int64_t recorded_frames = 0;
+    {
+        glapp::recorder recorder(*w, path, 30);
+        ASSERT_TRUE(recorder);
+        w->on_frame([](glapp::window& window) {
+            glClearColor(0.2f, 0.4f, 0.6f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+            if (window.frame_count() == 10) {
+                window.close();
+            }
+        });
+        app->run();
+        recorder.stop();
+        EXPECT_FALSE(recorder.recording());
+        recorded_frames = recorder.recorded_frames();
+    }
+    std::stringstream file;
+    file << std::ifstream(path, std::ios::binary).rdbuf();
+    std::remove(path);
+    const auto content = file.str();
+    if (recorded_frames == 0) {
+        EXPECT_TRUE(content.empty());
+        GTEST_SKIP() << "Recording is not supported by the context";
+    }
+    const std::string header = "YUV4MPEG2 W64 H32 F30:1 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n";
+    EXPECT_EQ(content.compare(0, header.size(), header), 0);
+    const size_t luma_size = 64 * 32;
+    const size_t chroma_size = 32 * 16;
+    const size_t frame_size = 6 + luma_size + chroma_size * 2;
+    ASSERT_EQ(content.size(), header.size() + static_cast<size_t>(recorded_frames) * frame_size);
+    // BT.601 limited range of the cleared color (51, 102, 153), whose 2x2 sums are twice the components
+    const int32_t expected_y = ((66 * 51 + 129 * 102 + 25 * 153 + 128) >> 8) + 16;
+    const int32_t expected_u = ((-38 * 102 - 74 * 204 + 112 * 306 + 256) >> 9) + 128;
+    const int32_t expected_v = ((112 * 102 - 94 * 204 - 18 * 306 + 256) >> 9) + 128;
+    for (int64_t i = 0; i < recorded_frames; ++i) {
+        const auto frame = content.substr(header.size() + static_cast<size_t>(i) * frame_size, frame_size);
+        ASSERT_EQ(frame.compare(0, 6, "FRAME\n"), 0);
+        EXPECT_EQ(frame.find_first_not_of(static_cast<char>(expected_y), 6), 6 + luma_size);
+        EXPECT_EQ(frame.find_first_not_of(static_cast<char>(expected_u), 6 + luma_size), 6 + luma_size + chroma_size);
+        EXPECT_EQ(frame.find_first_not_of(static_cast<char>(expected_v), 6 + luma_size + chroma_size), std::string::npos);
+    }
+}
+
+TEST_F(GlapTest, FrameExport)
+{
+    auto app = glapp::get();
+    auto w = app->add_headless_window(64, 32);
+    const char* name = "/glapp_test_frame_export";
+    glapp::frame_exporter exporter(*w, name);
+    if (!exporter) {
+        EXPECT_FALSE(glapp::frame_export_reader(name));
+        GTEST_SKIP() << "POSIX shared memory is not available";
+    }
+    // The memory of the existing exporter is never taken over
+    EXPECT_FALSE(glapp::frame_exporter(*w, name));
+    glapp::frame_export_reader reader(name);
+    ASSERT_TRUE(reader);
+    EXPECT_FALSE(reader.read_latest([](const glapp::captured_frame&) {}));
+    w->on_frame([](glapp::window& window) {
+        glClearColor(0.2f, 0.4f, 0.6f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        if (window.frame_count() == 10) {
+            window.close();
+        }
+    });
+    app->run();
+    int64_t frame_count = -1;
+    size_t mismatched_pixels = 0;
+    const bool read = reader.read_latest([&](const glapp::captured_frame& frame) {
+        frame_count = frame.frame_count();
+        EXPECT_EQ(frame.width(), 64);
+        EXPECT_EQ(frame.height(), 32);
+        ASSERT_EQ(frame.size_in_bytes(), 64u * 32u * 4u);
+        ASSERT_NE(frame.pixels(), nullptr);
+        const uint8_t expected[] = { 51, 102, 153, 255 };
+        for (size_t i = 0; i < frame.size_in_bytes(); i += 4) {
+            if (std::memcmp(frame.pixels() + i, expected, sizeof(expected)) != 0) {
+                ++mismatched_pixels;
+            }
+        }
+    });
+    if (exporter.exported_frames() == 0) {
+        EXPECT_FALSE(read);
+        GTEST_SKIP() << "Capturing is not supported by the context";
+    }
+    EXPECT_TRUE(read);
+    EXPECT_LE(exporter.exported_frames() - 1, frame_count);
+    EXPECT_EQ(mismatched_pixels, 0u);
+    // The same frame is not read twice
+    EXPECT_FALSE(reader.read_latest([](const glapp::captured_frame&) {}));
+    EXPECT_EQ(exporter.dropped_frames(), 0);
+}
+
+#if defined(GLAPP_SHARED_MEMORY)
+TEST_F(GlapTest, FrameExportCorruptHeader)
+{
+    const char* name = "/glapp_test_frame_export_corrupt";
+    shm_unlink(name);
+    const int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    ASSERT_GE(fd, 0);
+    const size_t slot_size = sizeof(glapp::internal::frame_export_slot) + 64;
+    const size_t size = sizeof(glapp::internal::frame_export_header) + slot_size * 2;
+    ASSERT_EQ(ftruncate(fd, static_cast<off_t>(size)), 0);
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    ASSERT_NE(memory, MAP_FAILED);
+    auto header = new (memory) glapp::internal::frame_export_header {};
+    std::memcpy(header->magic, "GLAPPFX", 8);
+    header->version = glapp::internal::frame_export_version;
+    header->slot_size = slot_size;
+    header->capacity = 64;
+    header->slot_count = 2;
+    EXPECT_TRUE(glapp::frame_export_reader(name));
+    // The reader rejects the layout which does not match the memory
+    header->slot_count = 0;
+    EXPECT_FALSE(glapp::frame_export_reader(name));
+    header->slot_count = 3;
+    EXPECT_FALSE(glapp::frame_export_reader(name));
+    header->slot_count = 2;
+    header->capacity = 65;
+    EXPECT_FALSE(glapp::frame_export_reader(name));
+    header->capacity = 64;
+    header->slot_size = slot_size + 1;
+    EXPECT_FALSE(glapp::frame_export_reader(name));
+    munmap(memory, size);
+    shm_unlink(name);
+}
+#endif
+
+TEST_F(GlapTest, Throttle)
+{
+    auto app = glapp::get();
+    auto w = app->add_window(320, 240, nullptr);
+    EXPECT_TRUE(w->throttle_policy().pause_when_minimized());
+    EXPECT_TRUE(w->throttle_policy().pause_when_hidden());
+    EXPECT_DOUBLE_EQ(w->throttle_policy().unfocused_fps(), 0.0);
+    w->set_throttle_policy(glapp::throttle_policy().set_unfocused_fps(10.0));
+    EXPECT_DOUBLE_EQ(w->throttle_policy().unfocused_fps(), 10.0);
+    EXPECT_FALSE(w->paused());
+    w->on_frame([](glapp::window& window) {
+        if (window.frame_count() == 2) {
+            window.set_visible(false);
+            EXPECT_TRUE(window.paused());
+        } else if (window.frame_count() == 5) {
+            window.close();
+        }
+    });
+    // Counts the frames of another window while the first one is hidden
+    auto counter = app->add_window(320, 240, nullptr);
+    int64_t hidden_frame_count = -1;
+    counter->on_frame([&](glapp::window& window) {
+        if (w->paused() && hidden_frame_count < 0) {
+            hidden_frame_count = w->frame_count();
+        } else if (window.frame_count() == 20) {
+            EXPECT_EQ(w->frame_count(), hidden_frame_count);
+            w->set_visible(true);
+        } else if (w->should_close()) {
+            window.close();
+        }
+    });
+    // The window created hidden keeps drawing
+    auto created_hidden = app->add_window(320, 240, nullptr, glapp::window_options().set_visible_on_created(false));
+    EXPECT_FALSE(created_hidden->visible());
+    EXPECT_FALSE(created_hidden->paused());
+    created_hidden->on_frame([](glapp::window& window) {
+        if (window.frame_count() == 2) {
+            window.close();
+        }
+    });
+    app->run();
+    EXPECT_EQ(created_hidden->frame_count(), 3);
+    EXPECT_EQ(hidden_frame_count, 3);
+    EXPECT_EQ(w->frame_count(), 6);
+    EXPECT_EQ(w->frame_stats().dropped_frames(), 0);
+}
+
+TEST_F(GlapTest, ProfilingZone)
+{
+    auto app = glapp::get();
+    auto w = app->add_window(320, 240, nullptr);
+    app->start_trace();
+    w->on_frame([](glapp::window& window) {
+        GLAPP_ZONE("outer_zone");
+        {
+            GLAPP_ZONE("inner_zone");
+            GLAPP_COUNTER("frame_counter", window.frame_count());
+        }
+        if (window.frame_count() == 2) {
+            window.close();
+        }
+    });
+    app->run();
+    app->stop_trace();
+    const char* path = "glapp_test_profiling.json";
+    ASSERT_TRUE(app->write_trace(path));
+    std::stringstream trace;
+    trace << std::ifstream(path).rdbuf();
+    std::remove(path);
+    const auto json = trace.str();
+    EXPECT_NE(json.find("\"name\":\"outer_zone\",\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"inner_zone\",\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"frame_counter\",\"ph\":\"C\""), std::string::npos);
+    EXPECT_NE(json.find("\"args\":{\"value\":2.000}"), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"windows\",\"ph\":\"C\""), std::string::npos);
+}